@@ -0,0 +1,227 @@
+// Checks the access sets KOIN declares through get_access_set against the
+// objects its calls actually read and write. Every call may only touch keys it
+// declared, and calls that succeed must touch exactly those keys. Exits with an
+// error when any call does not.
+//
+// usage: access_set_check <koin module>
+
+#include <koinos/contracts.hpp>
+#include <koinos/buffer.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/chain/chain.h>
+#include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/token/token.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size    = 25;
+constexpr std::size_t max_buffer_size = 1024;
+constexpr uint64_t initial_balance    = 1'000'000;
+constexpr uint64_t genesis_time_ms    = 1'640'995'200'000;
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t consume_account_rc = 0x80e3f5c9;
+constexpr uint32_t transfer           = 0x27f576ca;
+constexpr uint32_t mint               = 0xdc6f17bb;
+constexpr uint32_t burn               = 0x859facc5;
+constexpr uint32_t get_access_set     = 0x65b7c557;
+
+} // entries
+
+using get_access_set_result = contracts::koin::get_access_set_result< 18, 32, 18, 32 >;
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename Bytes >
+void set_bytes( Bytes& b, const std::string& s )
+{
+   b.set( reinterpret_cast< const uint8_t* >( s.data() ), s.size() );
+}
+
+std::string make_address( char tag )
+{
+   std::string a( constants::address_size, tag );
+   a[0] = '\0';
+   return a;
+}
+
+struct call
+{
+   const char* name;
+   uint32_t    entry_point;
+   std::string args;
+   bool        succeeds;  // Touches exactly its declared keys
+};
+
+std::string transfer( const std::string& from, const std::string& to, uint64_t value )
+{
+   contracts::token::transfer_arguments< constants::address_size, constants::address_size > args;
+   set_bytes( args.mutable_from(), from );
+   set_bytes( args.mutable_to(), to );
+   args.set_value( value );
+   return serialize( args );
+}
+
+std::string mint( const std::string& to, uint64_t value )
+{
+   contracts::token::mint_arguments< constants::address_size > args;
+   set_bytes( args.mutable_to(), to );
+   args.set_value( value );
+   return serialize( args );
+}
+
+std::string burn( const std::string& from, uint64_t value )
+{
+   contracts::token::burn_arguments< constants::address_size > args;
+   set_bytes( args.mutable_from(), from );
+   args.set_value( value );
+   return serialize( args );
+}
+
+std::string consume_account_rc( const std::string& account, uint64_t value )
+{
+   chain::consume_account_rc_arguments< 32 > args;
+   set_bytes( args.mutable_account(), account );
+   args.set_value( value );
+   return serialize( args );
+}
+
+// Store keys of a declared access list
+template< typename Keys >
+std::set< std::string > store_keys( const std::string& koin_id, const Keys& keys )
+{
+   std::set< std::string > out;
+   for ( uint32_t i = 0; i < keys.get_length(); i++ )
+   {
+      const auto& k = keys[i];
+
+      system::object_space space;
+      set_bytes( space.mutable_zone(), koin_id );
+      space.set_id( k.get_space() );
+      space.set_system( true );
+
+      out.insert( mock::store_key( space, std::string( reinterpret_cast< const char* >( k.get_key().get_const() ), k.get_key().get_length() ) ) );
+   }
+   return out;
+}
+
+bool check( const char* what, const std::set< std::string >& observed, const std::set< std::string >& declared, bool exact )
+{
+   bool ok = exact ? observed == declared : std::includes( declared.begin(), declared.end(), observed.begin(), observed.end() );
+   if ( !ok )
+      std::fprintf( stderr, "  %s: %zu observed, %zu declared\n", what, observed.size(), declared.size() );
+   return ok;
+}
+
+int main( int argc, char** argv )
+{
+   if ( argc != 2 )
+   {
+      std::fprintf( stderr, "usage: %s <koin module>\n", argv[0] );
+      return 2;
+   }
+
+   const auto& koin_id = contracts::koin_address();
+   mock::load_contract( koin_id, argv[1], true );
+   mock::set_caller( "", chain::privilege::kernel_mode );
+   mock::set_head_block_time( constants::genesis_time_ms );
+
+   auto alice = make_address( 'a' );
+   auto bob   = make_address( 'b' );
+   auto carol = make_address( 'c' );
+
+   for ( const auto& account : { alice, bob, carol } )
+      mock::set_authority( account, true );
+
+   for ( const auto& account : { alice, bob } )
+   {
+      if ( mock::invoke( koin_id, entries::mint, mint( account, constants::initial_balance ) ).first != 0 )
+      {
+         std::fprintf( stderr, "could not seed balances\n" );
+         return 1;
+      }
+   }
+
+   // Mana regenerates over time, so every account starts with full mana
+   mock::set_head_block_time( constants::genesis_time_ms + 432'000'000 );
+
+   std::vector< call > calls = {
+      { "transfer",                entries::transfer,           transfer( alice, bob, 10 ),                           true },
+      { "transfer to new account", entries::transfer,           transfer( bob, carol, 10 ),                           true },
+      { "transfer over balance",   entries::transfer,           transfer( alice, bob, constants::initial_balance * 2 ), false },
+      { "transfer to self",        entries::transfer,           transfer( alice, alice, 1 ),                          false },
+      { "mint",                    entries::mint,               mint( carol, 10 ),                                    true },
+      { "burn",                    entries::burn,               burn( bob, 10 ),                                      true },
+      { "burn over balance",       entries::burn,               burn( carol, constants::initial_balance ),            false },
+      { "consume_account_rc",      entries::consume_account_rc, consume_account_rc( alice, 10 ),                      true },
+      { "consume_account_rc over", entries::consume_account_rc, consume_account_rc( alice, constants::initial_balance * 2 ), false },
+   };
+
+   bool ok = true;
+   mock::track_accesses( true );
+
+   std::printf( "%-26s %8s %8s %8s\n", "call", "reads", "writes", "declared" );
+
+   for ( const auto& c : calls )
+   {
+      contracts::koin::get_access_set_arguments< 128 > args;
+      args.set_entry_point( c.entry_point );
+      set_bytes( args.mutable_arguments(), c.args );
+
+      auto [ code, result ] = mock::invoke( koin_id, entries::get_access_set, serialize( args ) );
+      if ( code != 0 )
+      {
+         std::fprintf( stderr, "get_access_set for %s exited with %d\n", c.name, code );
+         return 1;
+      }
+
+      get_access_set_result declared;
+      koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( result.data() ), result.size() );
+      declared.deserialize( rdbuf );
+
+      mock::clear_accesses();
+      auto call_code = mock::invoke( koin_id, c.entry_point, c.args ).first;
+      auto observed = mock::accesses();
+
+      bool exact = c.succeeds && call_code == 0;
+      bool call_ok = check( "reads", observed.reads, store_keys( koin_id, declared.get_reads() ), exact )
+                   & check( "writes", observed.writes, store_keys( koin_id, declared.get_writes() ), exact );
+
+      if ( c.succeeds && call_code != 0 )
+      {
+         std::fprintf( stderr, "  %s exited with %d\n", c.name, call_code );
+         call_ok = false;
+      }
+
+      std::printf( "%-26s %8zu %8zu %8u %s\n",
+         c.name,
+         observed.reads.size(),
+         observed.writes.size(),
+         declared.get_reads().get_length(),
+         call_ok ? "" : "FAIL" );
+
+      ok &= call_ok;
+   }
+
+   return ok ? 0 : 1;
+}
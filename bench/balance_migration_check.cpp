@@ -0,0 +1,212 @@
+// Checks that KOIN takes over balances stored in either layout. Accounts are
+// seeded with a protobuf encoded mana_balance_object and with a balance_record,
+// read, written back by a transfer, and read again. Balances and mana must
+// carry over exactly, and the written back objects must be in the layout the
+// build writes: records with BUILD_WITH_BALANCE_RECORDS, protobuf otherwise.
+// A protobuf object whose last mana update does not fit a record must revert.
+// Exits with an error when any step does not hold.
+//
+// usage: balance_migration_check <koin module>
+
+#include <koinos/contracts.hpp>
+#include <koinos/buffer.hpp>
+#include <koinos/contracts/balance_record.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/chain/chain.h>
+#include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/token/token.h>
+
+#include <array>
+#include <cstdio>
+#include <string>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size    = 25;
+constexpr std::size_t max_buffer_size = 256;
+constexpr uint32_t balance_id         = 1;
+constexpr uint64_t head_block_time    = 1'640'995'200'000;
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t balance_of     = 0x5c721497;
+constexpr uint32_t transfer       = 0x27f576ca;
+constexpr uint32_t get_account_rc = 0x2d464aab;
+
+} // entries
+
+struct balance
+{
+   uint64_t value;
+   uint64_t mana;
+};
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename T >
+T deserialize( std::string s )
+{
+   T t;
+   koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( s.data() ), s.size() );
+   t.deserialize( rdbuf );
+   return t;
+}
+
+template< typename Bytes >
+void set_bytes( Bytes& b, const std::string& s )
+{
+   b.set( reinterpret_cast< const uint8_t* >( s.data() ), s.size() );
+}
+
+std::string make_address( char tag )
+{
+   std::string a( constants::address_size, tag );
+   a[0] = '\0';
+   return a;
+}
+
+system::object_space balance_space()
+{
+   const auto& koin_id = contracts::koin_address();
+   system::object_space space;
+   space.mutable_zone().set( reinterpret_cast< const uint8_t* >( koin_id.data() ), koin_id.size() );
+   space.set_id( constants::balance_id );
+   space.set_system( true );
+   return space;
+}
+
+std::string protobuf_object( const balance& b, uint64_t last_mana_update = constants::head_block_time )
+{
+   contracts::koin::mana_balance_object obj;
+   obj.set_balance( b.value );
+   obj.set_mana( b.mana );
+   obj.set_last_mana_update( last_mana_update );
+   return serialize( obj );
+}
+
+std::string record_object( const balance& b )
+{
+   contracts::balance_record rec;
+   rec.set_balance( b.value );
+   rec.set_mana( b.mana );
+   rec.set_last_mana_update( constants::head_block_time );
+   return std::string( rec.bytes() );
+}
+
+// Balance and mana as KOIN reports them. Mana does not regenerate, since the
+// head block time is the objects' last mana update.
+balance read( const std::string& account )
+{
+   const auto& koin_id = contracts::koin_address();
+
+   contracts::token::balance_of_arguments< constants::address_size > balance_args;
+   set_bytes( balance_args.mutable_owner(), account );
+   auto [ balance_code, balance_result ] = mock::invoke( koin_id, entries::balance_of, serialize( balance_args ) );
+
+   chain::get_account_rc_arguments< 32 > rc_args;
+   set_bytes( rc_args.mutable_account(), account );
+   auto [ rc_code, rc_result ] = mock::invoke( koin_id, entries::get_account_rc, serialize( rc_args ) );
+
+   if ( balance_code != 0 || rc_code != 0 )
+      return { ~uint64_t( 0 ), ~uint64_t( 0 ) };
+
+   return {
+      deserialize< contracts::token::balance_of_result >( balance_result ).get_value(),
+      deserialize< chain::get_account_rc_result >( rc_result ).get_value()
+   };
+}
+
+bool expect( const char* what, const std::string& account, const balance& expected )
+{
+   auto b = read( account );
+   bool ok = b.value == expected.value && b.mana == expected.mana;
+   std::printf( "%-36s balance %10llu mana %10llu %s\n", what, (unsigned long long)b.value, (unsigned long long)b.mana, ok ? "" : "MISMATCH" );
+   return ok;
+}
+
+bool expect_layout( const char* what, const std::string& account, const balance& expected )
+{
+#ifdef BUILD_WITH_BALANCE_RECORDS
+   auto written = record_object( expected );
+#else
+   auto written = protobuf_object( expected );
+#endif
+   bool ok = mock::objects().at( mock::store_key( balance_space(), account ) ) == written;
+   std::printf( "%-36s %s\n", what, ok ? "" : "MISMATCH" );
+   return ok;
+}
+
+int main( int argc, char** argv )
+{
+   if ( argc != 2 )
+   {
+      std::fprintf( stderr, "usage: %s <koin module>\n", argv[0] );
+      return 2;
+   }
+
+   const auto& koin_id = contracts::koin_address();
+   mock::load_contract( koin_id, argv[1], true );
+   mock::set_head_block_time( constants::head_block_time );
+
+   auto legacy = make_address( 'p' );
+   auto record = make_address( 'r' );
+   auto recipient = make_address( 'x' );
+
+   balance legacy_balance = { 1'000'000, 600'000 };
+   balance record_balance = { 2'000'000, 1'500'000 };
+   constexpr uint64_t value = 100'000;
+
+   mock::set_object( balance_space(), legacy, protobuf_object( legacy_balance ) );
+   mock::set_object( balance_space(), record, record_object( record_balance ) );
+
+   bool ok = true;
+   ok &= expect( "protobuf object read", legacy, legacy_balance );
+   ok &= expect( "record read", record, record_balance );
+
+   for ( const auto& from : { legacy, record } )
+   {
+      contracts::token::transfer_arguments< constants::address_size, constants::address_size > args;
+      set_bytes( args.mutable_from(), from );
+      set_bytes( args.mutable_to(), recipient );
+      args.set_value( value );
+
+      mock::set_caller( from, chain::privilege::user_mode );
+      if ( mock::invoke( koin_id, entries::transfer, serialize( args ) ).first != 0 )
+      {
+         std::fprintf( stderr, "transfer failed\n" );
+         return 1;
+      }
+   }
+
+   balance legacy_after = { legacy_balance.value - value, legacy_balance.mana - value };
+   balance record_after = { record_balance.value - value, record_balance.mana - value };
+
+   ok &= expect_layout( "protobuf object written back", legacy, legacy_after );
+   ok &= expect_layout( "record written back", record, record_after );
+   ok &= expect( "protobuf object read again", legacy, legacy_after );
+   ok &= expect( "record read again", record, record_after );
+   ok &= expect( "recipient", recipient, { 2 * value, 2 * value } );
+
+   auto out_of_range = make_address( 'o' );
+   mock::set_object( balance_space(), out_of_range, protobuf_object( legacy_balance, contracts::balance_record::max_time + 1 ) );
+
+   contracts::token::balance_of_arguments< constants::address_size > args;
+   set_bytes( args.mutable_owner(), out_of_range );
+   bool reverted = mock::invoke( koin_id, entries::balance_of, serialize( args ) ).first != 0;
+   std::printf( "%-36s %s\n", "out of range mana update reverts", reverted ? "" : "MISMATCH" );
+   ok &= reverted;
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,397 @@
+// Runs the entry points of koin, resources and pow through the host system
+// call mock over pre-populated state and reports, per operation, wall time,
+// system calls made, bytes serialized to state, events and results, and heap
+// allocations made by the contract.
+//
+// Heap allocations are counted as in startup_check, through an operator new the
+// bench exports to the loaded modules. Modules built with the arena bind
+// operator new to their own, so only requests the arena cannot serve reach it.
+// Host builds without BUILD_WITH_ARENA run every entry twice, against modules
+// built without and with the arena, and compare heap allocations per
+// operation. std::string and std::vector code instantiated inside libstdc++.so
+// still allocates through the global operator new in arena modules, while the
+// wasm build serves it from the arena, so the host figures understate the
+// saving.
+
+#include <koinos/contracts.hpp>
+#include <koinos/crypto.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/chain/authority.h>
+#include <koinos/contracts/pow/pow.h>
+#include <koinos/contracts/resources/resources.h>
+#include <koinos/contracts/token/token.h>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size       = 25;
+constexpr std::size_t max_buffer_size    = 2048;
+constexpr std::size_t num_ops            = 20'000;
+constexpr uint64_t initial_balance       = 1'000'000'000'000;
+constexpr uint64_t genesis_time_ms       = 1'640'995'200'000; // Before the PoW end date
+constexpr uint64_t block_interval_ms     = 3'000;
+const std::string resources_id           = "resources";
+const std::string pow_id                 = "pow";
+const std::array< std::size_t, 2 > state_sizes = { 1'000, 100'000 };
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t get_account_rc          = 0x2d464aab;
+constexpr uint32_t consume_account_rc      = 0x80e3f5c9;
+constexpr uint32_t balance_of              = 0x5c721497;
+constexpr uint32_t transfer                = 0x27f576ca;
+constexpr uint32_t mint                    = 0xdc6f17bb;
+constexpr uint32_t burn                    = 0x859facc5;
+constexpr uint32_t get_resource_limits     = 0x427a0394;
+constexpr uint32_t consume_block_resources = 0x9850b1fd;
+constexpr uint32_t get_difficulty          = 0x2e40cb65;
+constexpr uint32_t process_block_signature = 0; // Any entry other than get_difficulty
+
+} // entries
+
+using process_block_signature_arguments = chain::process_block_signature_arguments<
+      system::detail::max_hash_size,
+      system::detail::max_hash_size,
+      system::detail::max_hash_size,
+      system::detail::max_hash_size,
+      system::detail::max_address_size,
+      system::detail::max_proposal_length,
+      system::detail::max_hash_size,
+      128 >;
+
+// Allocations made by the contracts. The bench exports these operators so the
+// dlopened contract modules resolve to them.
+bool counting = false;
+uint64_t allocations = 0;
+
+struct module_set
+{
+   const char* label;
+   const char* koin;
+   const char* resources;
+   const char* pow;
+};
+
+// Heap allocations per operation of every run, one list per module set
+std::vector< std::vector< std::pair< std::string, double > > > allocation_runs;
+
+void* operator new( std::size_t size )
+{
+   if ( counting && !mock::in_host() )
+      allocations++;
+
+   if ( void* p = std::malloc( size ? size : 1 ) )
+      return p;
+
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+   std::free( p );
+}
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename Bytes >
+void set_bytes( Bytes& b, const std::string& s )
+{
+   b.set( reinterpret_cast< const uint8_t* >( s.data() ), s.size() );
+}
+
+std::string make_address( uint64_t i )
+{
+   std::string a( constants::address_size, '\0' );
+   for ( std::size_t b = 0; b < sizeof( i ); b++ )
+      a[ constants::address_size - 1 - b ] = char( i >> ( b * 8 ) );
+   a[1] = '\x6b';
+   return a;
+}
+
+struct op
+{
+   std::string contract_id;
+   uint32_t    entry_point;
+   std::string args;
+};
+
+struct bench_state
+{
+   std::vector< std::string > accounts;
+   std::mt19937_64            rng{ 0x6b6f696e };
+   uint64_t                   height = 0;
+
+   const std::string& account() { return accounts[ rng() % accounts.size() ]; }
+
+   void next_block()
+   {
+      height++;
+      mock::set_head_height( height );
+      mock::set_head_block_time( constants::genesis_time_ms + height * constants::block_interval_ms );
+   }
+};
+
+void check( const char* what, int32_t code )
+{
+   if ( code != 0 )
+   {
+      counting = false;
+      std::fprintf( stderr, "%s exited with %d\n", what, code );
+      std::exit( 1 );
+   }
+}
+
+// Serialized arguments are prepared up front so only the invocation is measured
+void run( const char* name, bench_state& s, const std::vector< op >& ops, bool advance_blocks = false )
+{
+   mock::clear_events();
+   mock::reset_counters();
+   allocations = 0;
+   std::chrono::steady_clock::duration elapsed{};
+
+   for ( const auto& o : ops )
+   {
+      if ( advance_blocks )
+         s.next_block();
+
+      counting = true;
+      auto start = std::chrono::steady_clock::now();
+      auto [ code, result ] = mock::invoke( o.contract_id, o.entry_point, o.args );
+      elapsed += std::chrono::steady_clock::now() - start;
+      counting = false;
+
+      check( name, code );
+   }
+
+   const auto& c = mock::get_counters();
+   double n = double( ops.size() );
+
+   std::printf( "%-28s %10zu %12.1f %12.2f %12.1f %12.2f\n",
+      name,
+      s.accounts.size(),
+      double( std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count() ) / n,
+      double( c.system_calls ) / n,
+      double( c.bytes_serialized ) / n,
+      double( allocations ) / n );
+
+   allocation_runs.back().emplace_back( name + std::string( "/" ) + std::to_string( s.accounts.size() ), double( allocations ) / n );
+}
+
+void seed_difficulty()
+{
+   // Difficulty 1 accepts every proof so no mining is needed
+   contracts::pow::difficulty_metadata< 32, 32 > meta;
+   std::array< uint8_t, 32 > bin;
+
+   bin.fill( 0xff );
+   meta.mutable_target().set( bin.data(), bin.size() );
+
+   bin.fill( 0 );
+   bin[31] = 1;
+   meta.mutable_difficulty().set( bin.data(), bin.size() );
+
+   meta.set_last_block_time( constants::genesis_time_ms );
+   meta.set_target_block_interval( 10 );
+
+   system::object_space space;
+   set_bytes( space.mutable_zone(), constants::pow_id );
+   space.set_id( 0 );
+   space.set_system( true );
+
+   mock::set_object( space, "", serialize( meta ) );
+}
+
+void bench_state_size( std::size_t num_accounts )
+{
+   const auto& koin_id = contracts::koin_address();
+
+   mock::reset_state();
+   mock::set_caller( "", chain::privilege::kernel_mode );
+
+   bench_state s;
+   s.next_block();
+
+   for ( std::size_t i = 0; i < num_accounts; i++ )
+   {
+      s.accounts.push_back( make_address( i ) );
+      mock::set_authority( s.accounts.back(), true );
+
+      contracts::token::mint_arguments< constants::address_size > args;
+      set_bytes( args.mutable_to(), s.accounts.back() );
+      args.set_value( constants::initial_balance );
+      check( "seed mint", mock::invoke( koin_id, entries::mint, serialize( args ) ).first );
+   }
+
+   seed_difficulty();
+
+   auto make_ops = []( auto&& make )
+   {
+      std::vector< op > ops;
+      ops.reserve( constants::num_ops );
+      for ( std::size_t i = 0; i < constants::num_ops; i++ )
+         ops.push_back( make() );
+      return ops;
+   };
+
+   run( "koin.balance_of", s, make_ops( [&]
+   {
+      contracts::token::balance_of_arguments< constants::address_size > args;
+      set_bytes( args.mutable_owner(), s.account() );
+      return op{ koin_id, entries::balance_of, serialize( args ) };
+   } ) );
+
+   run( "koin.get_account_rc", s, make_ops( [&]
+   {
+      chain::get_account_rc_arguments< 32 > args;
+      set_bytes( args.mutable_account(), s.account() );
+      return op{ koin_id, entries::get_account_rc, serialize( args ) };
+   } ) );
+
+   run( "koin.consume_account_rc", s, make_ops( [&]
+   {
+      chain::consume_account_rc_arguments< 32 > args;
+      set_bytes( args.mutable_account(), s.account() );
+      args.set_value( 1 );
+      return op{ koin_id, entries::consume_account_rc, serialize( args ) };
+   } ), true );
+
+   run( "koin.transfer", s, make_ops( [&]
+   {
+      contracts::token::transfer_arguments< constants::address_size, constants::address_size > args;
+      const auto& from = s.account();
+      auto to = &s.account();
+      while ( *to == from )
+         to = &s.account();
+
+      set_bytes( args.mutable_from(), from );
+      set_bytes( args.mutable_to(), *to );
+      args.set_value( 1 );
+      return op{ koin_id, entries::transfer, serialize( args ) };
+   } ), true );
+
+   run( "koin.mint", s, make_ops( [&]
+   {
+      contracts::token::mint_arguments< constants::address_size > args;
+      set_bytes( args.mutable_to(), s.account() );
+      args.set_value( 1 );
+      return op{ koin_id, entries::mint, serialize( args ) };
+   } ) );
+
+   run( "koin.burn", s, make_ops( [&]
+   {
+      contracts::token::burn_arguments< constants::address_size > args;
+      set_bytes( args.mutable_from(), s.account() );
+      args.set_value( 1 );
+      return op{ koin_id, entries::burn, serialize( args ) };
+   } ), true );
+
+   run( "resources.get_resource_limits", s, make_ops( [&]
+   {
+      return op{ constants::resources_id, entries::get_resource_limits, std::string() };
+   } ) );
+
+   run( "resources.consume_block", s, make_ops( [&]
+   {
+      chain::consume_block_resources_arguments args;
+      args.set_disk_storage_consumed( 1'000 );
+      args.set_network_bandwidth_consumed( 10'000 );
+      args.set_compute_bandwidth_consumed( 1'000'000 );
+      return op{ constants::resources_id, entries::consume_block_resources, serialize( args ) };
+   } ), true );
+
+   run( "pow.get_difficulty", s, make_ops( [&]
+   {
+      return op{ constants::pow_id, entries::get_difficulty, std::string() };
+   } ) );
+
+   // One signed block is replayed at every height, it always meets difficulty 1
+   std::string public_key( 33, '\x02' );
+   std::string signature( 65, '\x1b' );
+   std::string digest = "\x12\x20" + std::string( 32, '\x5a' );
+   mock::set_public_key( signature, digest, public_key );
+
+   contracts::pow::pow_signature_data< 32, 65 > sig_data;
+   set_bytes( sig_data.mutable_nonce(), std::string( 32, '\x01' ) );
+   set_bytes( sig_data.mutable_recoverable_signature(), signature );
+
+   process_block_signature_arguments block_args;
+   set_bytes( block_args.mutable_digest(), digest );
+   set_bytes( block_args.mutable_header().mutable_signer(), koinos::address_from_public_key( public_key ) );
+   set_bytes( block_args.mutable_signature(), serialize( sig_data ) );
+   auto block_arg_bytes = serialize( block_args );
+
+   run( "pow.process_block_signature", s, make_ops( [&]
+   {
+      return op{ constants::pow_id, entries::process_block_signature, block_arg_bytes };
+   } ), true );
+}
+
+int main()
+{
+#ifdef BUILD_WITH_ARENA
+   const char* configured = "with arena";
+#else
+   const char* configured = "without arena";
+#endif
+
+   std::vector< module_set > sets = { { configured, KOIN_MODULE, RESOURCES_MODULE, POW_MODULE } };
+#ifdef KOIN_ARENA_MODULE
+   sets.push_back( { "with arena", KOIN_ARENA_MODULE, RESOURCES_ARENA_MODULE, POW_ARENA_MODULE } );
+#endif
+
+   std::printf( "allocs/op counts allocations reaching the global operator new. Arena modules still send\n"
+                "those made inside libstdc++ there, which wasm serves from the arena, so they overstate wasm\n" );
+
+   for ( const auto& set : sets )
+   {
+      mock::load_contract( contracts::koin_address(), set.koin, true );
+      mock::load_contract( constants::resources_id, set.resources, true );
+      mock::load_contract( constants::pow_id, set.pow, true );
+      allocation_runs.emplace_back();
+
+      std::printf( "\ncontracts %s\n", set.label );
+      std::printf( "%-28s %10s %12s %12s %12s %12s\n", "entry", "accounts", "ns/op", "syscalls/op", "bytes/op", "allocs/op" );
+
+      for ( auto size : constants::state_sizes )
+         bench_state_size( size );
+   }
+
+   if ( allocation_runs.size() == 2 )
+   {
+      std::printf( "\nheap allocations per operation\n" );
+      std::printf( "%-40s %14s %14s\n", "entry/accounts", "without arena", "with arena" );
+
+      const auto& heap = allocation_runs[0];
+      const auto& arena = allocation_runs[1];
+      for ( std::size_t i = 0; i < heap.size() && i < arena.size(); i++ )
+         std::printf( "%-40s %14.2f %14.2f\n", heap[i].first.c_str(), heap[i].second, arena[i].second );
+   }
+
+   return 0;
+}
@@ -0,0 +1,146 @@
+// Checks the event encoder of koinos/contracts/system_calls.hpp against
+// EmbeddedProto. Wasm builds encode events' chain::event_arguments by hand,
+// straight into the system call buffer. For events with short and long names,
+// empty, short and long payloads, and none or several impacted accounts, the
+// hand encoding must equal the serialization of the same chain::event_arguments
+// and must deserialize back to it. Encoding an event into any buffer too short
+// for it must revert without writing past the buffer's end. Exits with an error
+// when any event does not hold to this.
+//
+// usage: event_encoding_check
+
+#include <koinos/buffer.hpp>
+#include <koinos/contracts/system_calls.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/chain/chain.h>
+#include <koinos/contracts/koin/koin.h>
+#include <koinos/contracts/token/token.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size      = 25;
+constexpr std::size_t max_name_size     = 256;
+constexpr std::size_t max_payload_size  = 1 << 15;
+constexpr std::size_t max_impacted      = 4;
+constexpr std::size_t max_buffer_size   = max_name_size + max_payload_size + max_impacted * 64 + 64;
+constexpr std::size_t guard_size        = 64;
+constexpr uint8_t guard_byte            = 0xa5;
+
+} // constants
+
+using event_arguments = chain::event_arguments< constants::max_name_size, constants::max_payload_size, constants::max_impacted, constants::address_size >;
+
+// A payload of any size, as the serialized arguments it carries
+using blob = contracts::koin::get_access_set_arguments< constants::max_payload_size >;
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::vector< uint8_t > buf( constants::max_buffer_size );
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename T >
+bool check( const char* what, std::string_view name, const T& data, std::initializer_list< std::string_view > impacted )
+{
+   std::vector< uint8_t > buf( constants::max_buffer_size );
+   auto end = system::detail::encode_event( buf.data(), buf.data() + buf.size(), name, data, impacted );
+   std::string encoded( reinterpret_cast< const char* >( buf.data() ), end - buf.data() );
+
+   event_arguments expected;
+   expected.mutable_name().set( name.data(), name.size() );
+   auto payload = serialize( data );
+   expected.mutable_data().set( reinterpret_cast< const uint8_t* >( payload.data() ), payload.size() );
+   for ( auto account : impacted )
+   {
+      EmbeddedProto::FieldBytes< constants::address_size > a;
+      a.set( reinterpret_cast< const uint8_t* >( account.data() ), account.size() );
+      expected.add_impacted( a );
+   }
+
+   event_arguments decoded;
+   koinos::read_buffer rdbuf( buf.data(), end - buf.data() );
+   decoded.deserialize( rdbuf );
+
+   bool matches = encoded == serialize( expected );
+   bool round_trips = serialize( decoded ) == encoded;
+
+   std::printf( "%-28s %8zu bytes %s\n", what, encoded.size(), matches && round_trips ? "" : matches ? "DECODE MISMATCH" : "ENCODING MISMATCH" );
+   return matches && round_trips;
+}
+
+// Encodes into every buffer shorter than the event, each followed by guard bytes
+template< typename T >
+bool check_truncated( const char* what, std::string_view name, const T& data, std::initializer_list< std::string_view > impacted )
+{
+   std::vector< uint8_t > full( constants::max_buffer_size );
+   std::size_t size = system::detail::encode_event( full.data(), full.data() + full.size(), name, data, impacted ) - full.data();
+
+   bool reverted = true, intact = true;
+   for ( std::size_t n = 0; n < size; n++ )
+   {
+      std::vector< uint8_t > buf( n + constants::guard_size, constants::guard_byte );
+      bool r = false;
+      try
+      {
+         system::detail::encode_event( buf.data(), buf.data() + n, name, data, impacted );
+      }
+      catch ( const mock::exit_exception& e )
+      {
+         r = e.code == std::underlying_type_t< chain::error_code >( chain::error_code::reversion );
+      }
+      reverted &= r;
+      intact &= std::all_of( buf.begin() + n, buf.end(), []( uint8_t b ){ return b == constants::guard_byte; } );
+   }
+
+   std::printf( "%-28s %8zu bytes %s\n", what, size, reverted && intact ? "" : reverted ? "OVERRUN" : "NOT REVERTED" );
+   return reverted && intact;
+}
+
+int main()
+{
+   std::string from( constants::address_size, 'a' );
+   std::string to( constants::address_size, 'b' );
+
+   contracts::token::transfer_event< constants::address_size, constants::address_size > transfer;
+   transfer.mutable_from().set( reinterpret_cast< const uint8_t* >( from.data() ), from.size() );
+   transfer.mutable_to().set( reinterpret_cast< const uint8_t* >( to.data() ), to.size() );
+   transfer.set_value( 100'000'000 );
+
+   std::string long_name( 200, 'n' );
+
+   bool ok = true;
+   ok &= check( "transfer", "koinos.contracts.token.transfer_event", transfer, { to, from } );
+   ok &= check( "no impacted accounts", "koinos.contracts.token.transfer_event", transfer, {} );
+   ok &= check( "empty payload", "koinos.contracts.token.transfer_result", contracts::token::transfer_result(), { from } );
+   ok &= check( "two byte name length", long_name, transfer, { from } );
+
+   // Payload lengths around each length prefix size
+   for ( std::size_t size : { std::size_t( 1 ), std::size_t( 120 ), std::size_t( 127 ), std::size_t( 200 ), std::size_t( 16'380 ), std::size_t( 20'000 ) } )
+   {
+      blob b;
+      std::string bytes( size, 'x' );
+      b.mutable_arguments().set( reinterpret_cast< const uint8_t* >( bytes.data() ), bytes.size() );
+
+      std::string what = std::to_string( size ) + " byte payload argument";
+      ok &= check( what.c_str(), "payload", b, { from, to, from } );
+   }
+
+   // Truncated within the name, the payload and each impacted account
+   ok &= check_truncated( "truncated transfer", "koinos.contracts.token.transfer_event", transfer, { to, from } );
+   ok &= check_truncated( "truncated empty payload", "koinos.contracts.token.transfer_result", contracts::token::transfer_result(), { from, to } );
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,333 @@
+// Compares koinos/contracts/integer.hpp against the boost::multiprecision
+// arithmetic the contracts previously used. Every case is checked for
+// bit-exact output before it is timed, and zero divisors must fail the way
+// they did with boost.
+
+#include <koinos/contracts/integer.hpp>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace koinos::contracts;
+
+namespace constants {
+
+constexpr uint64_t mana_regen_time_ms               = 432'000'000;
+constexpr uint64_t decay_constant_default           = 18446596084619782819ull;
+constexpr uint64_t one_minus_decay_constant_default = 147989089768795ull;
+constexpr uint64_t print_rate_premium_default       = 1688;
+constexpr uint64_t print_rate_precision_default     = 1000;
+constexpr std::size_t num_inputs                    = 1 << 16;
+constexpr std::size_t num_rounds                    = 32;
+constexpr uint32_t initial_difficulty_bits          = 24;
+constexpr std::size_t walk_stride                   = 8;      // Steps between difficulties checked with the walk's adjustment
+constexpr std::size_t all_adjustments_stride        = 512;    // Steps between difficulties checked with every adjustment
+constexpr std::size_t descent_start_stride          = 8192;   // Climb steps between descents
+
+} // constants
+
+struct market
+{
+   uint64_t resource_supply;
+   uint64_t block_budget;
+   uint64_t block_limit;
+};
+
+namespace reference {
+
+using int128_t  = boost::multiprecision::int128_t;
+using uint128_t = boost::multiprecision::uint128_t;
+using uint256_t = boost::multiprecision::uint256_t;
+
+uint64_t mana_regen( uint64_t delta, uint64_t balance )
+{
+   return ( ( int128_t( delta ) * int128_t( balance ) ) / constants::mana_regen_time_ms ).convert_to< uint64_t >();
+}
+
+uint64_t initial_supply( uint64_t print_rate )
+{
+   return ( ( uint128_t( print_rate ) << 64 ) / constants::one_minus_decay_constant_default ).convert_to< uint64_t >();
+}
+
+uint64_t market_cost( const market& m, uint64_t rc_per_block )
+{
+   auto block_print_rate = ( constants::print_rate_premium_default * m.block_budget ) / constants::print_rate_precision_default;
+   auto max_resources = ( uint128_t( block_print_rate - m.block_budget ) << 64 ) / constants::one_minus_decay_constant_default;
+   uint128_t k = ( ( rc_per_block * max_resources ) / m.block_budget ) * ( max_resources - m.block_budget );
+
+   auto resource_limit = std::min( m.resource_supply - 1, m.block_limit );
+   auto new_supply = m.resource_supply - resource_limit;
+   auto consumed_rc = ( ( k + ( new_supply - 1 ) ) / new_supply ) - ( k / m.resource_supply );
+   return ( ( consumed_rc + ( resource_limit - 1 ) ) / resource_limit ).convert_to< uint64_t >();
+}
+
+uint64_t decayed_supply( uint64_t supply )
+{
+   return ( ( uint128_t( supply ) * constants::decay_constant_default ) >> 64 ).convert_to< uint64_t >();
+}
+
+void retarget( const uint8_t* difficulty_in, int64_t adjustment, uint8_t* difficulty_out, uint8_t* target_out )
+{
+   uint256_t difficulty;
+   boost::multiprecision::import_bits( difficulty, difficulty_in, difficulty_in + 32, 8 );
+   difficulty = difficulty + difficulty / 2048 * adjustment;
+   auto target = std::numeric_limits< uint256_t >::max() / difficulty;
+
+   for ( auto [ n, out ] : { std::make_pair( difficulty, difficulty_out ), std::make_pair( target, target_out ) } )
+   {
+      std::vector< uint8_t > bin;
+      boost::multiprecision::export_bits( n, std::back_inserter( bin ), 8 );
+      std::fill( out, out + 32 - bin.size(), 0 );
+      std::copy( bin.begin(), bin.end(), out + 32 - bin.size() );
+   }
+}
+
+} // reference
+
+namespace fixed {
+
+uint64_t mana_regen( uint64_t delta, uint64_t balance )
+{
+   return mul_div< constants::mana_regen_time_ms >( delta, balance );
+}
+
+uint64_t initial_supply( uint64_t print_rate )
+{
+   return uint64_t( ( uint128_t( print_rate ) << 64 ) / constants::one_minus_decay_constant_default );
+}
+
+uint64_t market_cost( const market& m, uint64_t rc_per_block )
+{
+   auto block_print_rate = ( constants::print_rate_premium_default * m.block_budget ) / constants::print_rate_precision_default;
+   auto max_resources = ( uint128_t( block_print_rate - m.block_budget ) << 64 ) / constants::one_minus_decay_constant_default;
+   uint128_t k = ( ( rc_per_block * max_resources ) / m.block_budget ) * ( max_resources - m.block_budget );
+
+   auto resource_limit = std::min( m.resource_supply - 1, m.block_limit );
+   auto new_supply = m.resource_supply - resource_limit;
+   auto consumed_rc = ( ( k + ( new_supply - 1 ) ) / new_supply ) - ( k / m.resource_supply );
+   return uint64_t( ( consumed_rc + ( resource_limit - 1 ) ) / resource_limit );
+}
+
+uint64_t decayed_supply( uint64_t supply )
+{
+   return uint64_t( ( uint128_t( supply ) * constants::decay_constant_default ) >> 64 );
+}
+
+void retarget( const uint8_t* difficulty_in, int64_t adjustment, uint8_t* difficulty_out, uint8_t* target_out )
+{
+   auto difficulty = uint256_t::from_big_endian( difficulty_in );
+   auto step = difficulty >> 11;
+   if ( adjustment >= 0 )
+      difficulty += step * uint64_t( adjustment );
+   else
+      difficulty -= step * uint64_t( -adjustment );
+
+   difficulty.to_big_endian( difficulty_out );
+   ( uint256_t::max() / difficulty ).to_big_endian( target_out );
+}
+
+} // fixed
+
+struct retarget_input
+{
+   uint8_t difficulty[32];
+   int64_t adjustment;
+};
+
+// Keeps the timed loops from being optimized away
+volatile uint64_t result_sink;
+
+inline uint64_t fold( uint64_t v ) { return v; }
+
+template< std::size_t N >
+uint64_t fold( const std::array< uint8_t, N >& a ) { return a[N - 1]; }
+
+template< typename Input, typename F >
+double time_ns( const std::vector< Input >& inputs, F&& f )
+{
+   uint64_t sink = 0;
+   auto start = std::chrono::steady_clock::now();
+
+   for ( std::size_t r = 0; r < constants::num_rounds; r++ )
+      for ( const auto& in : inputs )
+         sink += fold( f( in ) );
+
+   auto elapsed = std::chrono::steady_clock::now() - start;
+   result_sink = sink;
+
+   return double( std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count() ) / ( inputs.size() * constants::num_rounds );
+}
+
+template< typename F >
+bool throws_overflow( F&& f )
+{
+   try
+   {
+      f();
+   }
+   catch ( const std::overflow_error& )
+   {
+      return true;
+   }
+   return false;
+}
+
+template< typename Input, typename Ref, typename Fixed >
+bool run( const char* name, const std::vector< Input >& inputs, Ref&& ref, Fixed&& fix )
+{
+   std::size_t mismatches = 0;
+   for ( const auto& in : inputs )
+      if ( ref( in ) != fix( in ) )
+         mismatches++;
+
+   auto ref_ns = time_ns( inputs, ref );
+   auto fix_ns = time_ns( inputs, fix );
+
+   std::printf( "%-20s %12.2f %12.2f %9.2fx %12zu\n", name, ref_ns, fix_ns, ref_ns / fix_ns, mismatches );
+   return mismatches == 0;
+}
+
+retarget_input make_retarget( const reference::uint256_t& difficulty, int64_t adjustment )
+{
+   retarget_input r = {};
+   std::vector< uint8_t > bin;
+   boost::multiprecision::export_bits( difficulty, std::back_inserter( bin ), 8 );
+   std::copy( bin.begin(), bin.end(), r.difficulty + 32 - bin.size() );
+   r.adjustment = adjustment;
+   return r;
+}
+
+// Retargets from difficulties the contract's update rule reaches from the
+// genesis difficulty, which moves by adjustment steps of difficulty >> 11.
+// The climb under the largest raise runs until the next raise would leave 256
+// bits. From points along it, the descent under the largest cut runs down to
+// where the step is zero and the difficulty stops moving. Difficulties along
+// the walks are sampled and checked with the walk's own adjustment, a sparser
+// sample and the floor each descent ends on with every adjustment.
+std::vector< retarget_input > reachable_retargets()
+{
+   using reference::uint256_t;
+
+   constexpr int64_t max_raise = 1;
+   constexpr int64_t max_cut   = -99;
+
+   std::vector< retarget_input > inputs;
+   auto every_adjustment = [&]( const uint256_t& difficulty )
+   {
+      for ( int64_t adjustment = max_cut; adjustment <= max_raise; adjustment++ )
+         inputs.push_back( make_retarget( difficulty, adjustment ) );
+   };
+
+   uint256_t difficulty = uint256_t( 1 ) << constants::initial_difficulty_bits;
+   for ( std::size_t i = 0; ( difficulty >> 11 ) <= std::numeric_limits< uint256_t >::max() - difficulty; i++ )
+   {
+      if ( i % constants::walk_stride == 0 )
+         inputs.push_back( make_retarget( difficulty, max_raise ) );
+      if ( i % constants::all_adjustments_stride == 0 )
+         every_adjustment( difficulty );
+
+      if ( i % constants::descent_start_stride == 0 )
+      {
+         uint256_t d = difficulty;
+         for ( std::size_t j = 0; d >> 11; j++ )
+         {
+            if ( j % constants::walk_stride == 0 )
+               inputs.push_back( make_retarget( d, max_cut ) );
+            if ( j % constants::all_adjustments_stride == 0 )
+               every_adjustment( d );
+            d -= ( d >> 11 ) * -max_cut;
+         }
+         every_adjustment( d );
+      }
+
+      difficulty += difficulty >> 11;
+   }
+
+   return inputs;
+}
+
+int main()
+{
+   std::mt19937_64 rng( 0x6b6f696e );
+
+   std::vector< std::pair< uint64_t, uint64_t > > mana_inputs;
+   std::vector< uint64_t > supply_inputs;
+   std::vector< std::pair< market, uint64_t > > market_inputs;
+   std::vector< retarget_input > retarget_inputs;
+
+   for ( std::size_t i = 0; i < constants::num_inputs; i++ )
+   {
+      mana_inputs.emplace_back( rng() % ( constants::mana_regen_time_ms + 1 ), rng() >> ( rng() % 64 ) );
+      supply_inputs.push_back( rng() >> ( 8 + rng() % 56 ) );
+
+      market m;
+      m.block_budget    = 1000 + rng() % 100'000'000;
+      m.block_limit     = m.block_budget * ( 1 + rng() % 8 );
+      m.resource_supply = m.block_limit + 1 + ( rng() >> ( 4 + rng() % 40 ) );
+      market_inputs.emplace_back( m, rng() >> ( 20 + rng() % 40 ) );
+
+      retarget_input r = {};
+      uint64_t difficulty = ( rng() >> ( rng() % 40 ) ) | ( 1ull << 20 );
+      for ( int b = 0; b < 8; b++ )
+         r.difficulty[31 - b] = uint8_t( difficulty >> ( b * 8 ) );
+      r.adjustment = std::max( 1 - int64_t( rng() % 1'000'000 / 7000 ), int64_t( -99 ) );
+      retarget_inputs.push_back( r );
+   }
+
+   auto retarget_reachable = reachable_retargets();
+
+   std::printf( "%-20s %12s %12s %10s %12s\n", "case", "boost ns/op", "fixed ns/op", "speedup", "mismatches" );
+
+   bool ok = true;
+
+   ok &= run( "mana_regen", mana_inputs,
+      []( const auto& in ) { return reference::mana_regen( in.first, in.second ); },
+      []( const auto& in ) { return fixed::mana_regen( in.first, in.second ); } );
+
+   ok &= run( "initial_supply", supply_inputs,
+      []( uint64_t in ) { return reference::initial_supply( in ); },
+      []( uint64_t in ) { return fixed::initial_supply( in ); } );
+
+   ok &= run( "market_cost", market_inputs,
+      []( const auto& in ) { return reference::market_cost( in.first, in.second ); },
+      []( const auto& in ) { return fixed::market_cost( in.first, in.second ); } );
+
+   ok &= run( "decayed_supply", supply_inputs,
+      []( uint64_t in ) { return reference::decayed_supply( in ); },
+      []( uint64_t in ) { return fixed::decayed_supply( in ); } );
+
+   // Difficulty and target are compared as their full 64 byte encoding
+   auto retarget_bytes = []( auto f )
+   {
+      return [f]( const retarget_input& in )
+      {
+         std::array< uint8_t, 64 > out;
+         f( in.difficulty, in.adjustment, out.data(), out.data() + 32 );
+         return out;
+      };
+   };
+
+   ok &= run( "difficulty_retarget", retarget_inputs, retarget_bytes( reference::retarget ), retarget_bytes( fixed::retarget ) );
+   ok &= run( "retarget_reachable", retarget_reachable, retarget_bytes( reference::retarget ), retarget_bytes( fixed::retarget ) );
+
+   retarget_input zero = {};
+   volatile uint64_t zero_divisor = 0;
+
+   bool zero_ok = throws_overflow( [&] { retarget_bytes( reference::retarget )( zero ); } )
+               && throws_overflow( [&] { retarget_bytes( fixed::retarget )( zero ); } )
+               && throws_overflow( [&] { result_sink = mul_div( 1, 1, zero_divisor ); } )
+               && throws_overflow( [&] { reciprocal_divisor div( zero_divisor ); } );
+
+   std::printf( "%-20s %s\n", "zero_divisor", zero_ok ? "throws" : "FAIL" );
+   ok &= zero_ok;
+
+   return ok ? 0 : 1;
+}
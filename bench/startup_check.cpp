@@ -0,0 +1,128 @@
+// Reports the static initialization cost of every contract module, the system
+// calls and heap allocations made before main() runs, and the cost of the
+// pure KOIN metadata entries. Exits with an error when a contract does any
+// work at static initialization time or a metadata query makes a system call
+// other than get_arguments and exit, or allocates.
+//
+// usage: startup_check <koin module> [<contract module> ...]
+
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace koinos;
+
+namespace constants {
+
+// get_arguments and exit
+constexpr uint64_t dispatch_system_calls = 2;
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t name     = 0x82a3537f;
+constexpr uint32_t symbol   = 0xb76a7ca1;
+constexpr uint32_t decimals = 0xee80fd2f;
+
+} // entries
+
+// Allocations made by the contracts. The check exports these operators so the
+// dlopened contract modules resolve to them.
+bool counting = false;
+uint64_t allocations = 0;
+
+void* operator new( std::size_t size )
+{
+   if ( counting && !mock::in_host() )
+      allocations++;
+
+   if ( void* p = std::malloc( size ? size : 1 ) )
+      return p;
+
+   throw std::bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+   std::free( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+   std::free( p );
+}
+
+std::string module_name( const std::string& path )
+{
+   auto begin = path.find_last_of( '/' );
+   begin = begin == std::string::npos ? 0 : begin + 1;
+   return path.substr( begin, path.find_last_of( '.' ) - begin );
+}
+
+bool report( const char* what, const std::string& name, uint64_t max_system_calls )
+{
+   const auto& c = mock::get_counters();
+   bool ok = c.system_calls <= max_system_calls && allocations == 0;
+
+   std::printf( "%-10s %-12s %10llu %10llu %s\n",
+      what,
+      name.c_str(),
+      (unsigned long long)c.system_calls,
+      (unsigned long long)allocations,
+      ok ? "" : "FAIL" );
+
+   return ok;
+}
+
+int main( int argc, char** argv )
+{
+   if ( argc < 2 )
+   {
+      std::fprintf( stderr, "usage: %s <koin module> [<contract module> ...]\n", argv[0] );
+      return 2;
+   }
+
+   bool ok = true;
+
+   std::printf( "%-10s %-12s %10s %10s\n", "stage", "contract", "syscalls", "allocs" );
+
+   for ( int i = 1; i < argc; i++ )
+   {
+      auto name = module_name( argv[i] );
+
+      mock::reset_counters();
+      allocations = 0;
+
+      counting = true;
+      mock::load_contract( name, argv[i], true );
+      counting = false;
+
+      ok &= report( "static", name, 0 );
+   }
+
+   auto koin = module_name( argv[1] );
+
+   for ( auto [ what, entry ] : { std::make_pair( "name", entries::name ), std::make_pair( "symbol", entries::symbol ), std::make_pair( "decimals", entries::decimals ) } )
+   {
+      mock::reset_counters();
+      allocations = 0;
+
+      counting = true;
+      auto [ code, result ] = mock::invoke( koin, entry, std::string() );
+      counting = false;
+
+      if ( code != 0 )
+      {
+         std::fprintf( stderr, "%s.%s exited with %d\n", koin.c_str(), what, code );
+         return 1;
+      }
+
+      ok &= report( what, koin, constants::dispatch_system_calls );
+   }
+
+   return ok ? 0 : 1;
+}
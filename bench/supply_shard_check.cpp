@@ -0,0 +1,216 @@
+// Checks KOIN's sharded supply. State from before sharding keeps its total
+// until the first mint folds it into a shard, and total_supply stays the exact
+// sum of every balance while burns drive shards negative. A mint that takes
+// the total past 2^64 - 1 must revert, one that reaches it exactly must not.
+// Exits with an error when any step does not hold.
+//
+// usage: supply_shard_check <koin module>
+
+#include <koinos/contracts.hpp>
+#include <koinos/buffer.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/chain/chain.h>
+#include <koinos/contracts/token/token.h>
+
+#include <array>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size    = 25;
+constexpr std::size_t max_buffer_size = 256;
+constexpr uint32_t supply_id          = 0;
+constexpr uint32_t supply_shards      = 16;
+constexpr uint64_t legacy_supply      = 5'000'000;
+constexpr uint64_t head_block_time    = 1'640'995'200'000;
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t total_supply = 0xb0da3934;
+constexpr uint32_t transfer     = 0x27f576ca;
+constexpr uint32_t mint         = 0xdc6f17bb;
+constexpr uint32_t burn         = 0x859facc5;
+
+} // entries
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename T >
+T deserialize( std::string s )
+{
+   T t;
+   koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( s.data() ), s.size() );
+   t.deserialize( rdbuf );
+   return t;
+}
+
+template< typename Bytes >
+void set_bytes( Bytes& b, const std::string& s )
+{
+   b.set( reinterpret_cast< const uint8_t* >( s.data() ), s.size() );
+}
+
+std::string make_address( char tag )
+{
+   std::string a( constants::address_size, tag );
+   a[0] = '\0';
+   return a;
+}
+
+system::object_space supply_space()
+{
+   const auto& koin_id = contracts::koin_address();
+   system::object_space space;
+   space.mutable_zone().set( reinterpret_cast< const uint8_t* >( koin_id.data() ), koin_id.size() );
+   space.set_id( constants::supply_id );
+   space.set_system( true );
+   return space;
+}
+
+std::string supply_object( uint64_t value )
+{
+   contracts::token::balance_object obj;
+   obj.set_value( value );
+   return serialize( obj );
+}
+
+int32_t call( uint32_t entry_point, const std::string& args )
+{
+   return mock::invoke( contracts::koin_address(), entry_point, args ).first;
+}
+
+int32_t mint( const std::string& to, uint64_t value )
+{
+   contracts::token::mint_arguments< constants::address_size > args;
+   set_bytes( args.mutable_to(), to );
+   args.set_value( value );
+   return call( entries::mint, serialize( args ) );
+}
+
+int32_t burn( const std::string& from, uint64_t value )
+{
+   contracts::token::burn_arguments< constants::address_size > args;
+   set_bytes( args.mutable_from(), from );
+   args.set_value( value );
+   return call( entries::burn, serialize( args ) );
+}
+
+int32_t transfer( const std::string& from, const std::string& to, uint64_t value )
+{
+   contracts::token::transfer_arguments< constants::address_size, constants::address_size > args;
+   set_bytes( args.mutable_from(), from );
+   set_bytes( args.mutable_to(), to );
+   args.set_value( value );
+   return call( entries::transfer, serialize( args ) );
+}
+
+bool expect( const char* what, bool ok )
+{
+   std::printf( "%-44s %s\n", what, ok ? "" : "FAIL" );
+   return ok;
+}
+
+bool expect_supply( const char* what, uint64_t expected )
+{
+   auto [ code, result ] = mock::invoke( contracts::koin_address(), entries::total_supply, std::string() );
+   uint64_t supply = code == 0 ? deserialize< contracts::token::total_supply_result >( result ).get_value() : 0;
+   std::printf( "%-44s %20llu %s\n", what, (unsigned long long)supply, code == 0 && supply == expected ? "" : "MISMATCH" );
+   return code == 0 && supply == expected;
+}
+
+std::string shard_key( uint32_t shard )
+{
+   return mock::store_key( supply_space(), std::string( 1, char( shard ) ) );
+}
+
+int main( int argc, char** argv )
+{
+   if ( argc != 2 )
+   {
+      std::fprintf( stderr, "usage: %s <koin module>\n", argv[0] );
+      return 2;
+   }
+
+   const auto& koin_id = contracts::koin_address();
+   mock::load_contract( koin_id, argv[1], true );
+   mock::set_head_block_time( constants::head_block_time );
+
+   auto legacy_key = mock::store_key( supply_space(), "" );
+   auto minter = make_address( 'm' );
+
+   std::vector< std::string > holders;
+   for ( char tag = 'a'; tag < 'a' + char( constants::supply_shards ); tag++ )
+   {
+      holders.push_back( make_address( tag ) );
+      mock::set_authority( holders.back(), true );
+   }
+   mock::set_authority( minter, true );
+
+   bool ok = true;
+
+   // Supply written before sharding
+   mock::set_object( supply_space(), "", supply_object( constants::legacy_supply ) );
+   ok &= expect_supply( "legacy supply", constants::legacy_supply );
+
+   mock::set_caller( "", chain::privilege::kernel_mode );
+   uint64_t supply = constants::legacy_supply;
+   uint64_t minted = 1'000'000;
+
+   ok &= expect( "mint after upgrade", mint( minter, minted ) == 0 );
+   supply += minted;
+   ok &= expect( "legacy supply object removed", !mock::objects().count( legacy_key ) );
+   ok &= expect_supply( "supply after migration", supply );
+
+   // Spread the minted balance over every shard and burn it there, which
+   // leaves the shards the minter does not hash to negative
+   uint64_t share = minted / holders.size();
+   bool moved = true;
+   for ( const auto& holder : holders )
+   {
+      mock::set_caller( minter, chain::privilege::user_mode );
+      moved &= transfer( minter, holder, share ) == 0;
+      mock::set_caller( holder, chain::privilege::user_mode );
+      moved &= burn( holder, share / 2 ) == 0;
+      supply -= share / 2;
+   }
+   ok &= expect( "transfers and burns", moved );
+   ok &= expect_supply( "supply after burns", supply );
+
+   bool negative = false;
+   for ( uint32_t i = 0; i < constants::supply_shards; i++ )
+   {
+      auto itr = mock::objects().find( shard_key( i ) );
+      if ( itr != mock::objects().end() )
+         negative |= int64_t( deserialize< contracts::token::balance_object >( itr->second ).get_value() ) < 0;
+   }
+   ok &= expect( "a shard holds a negative delta", negative );
+
+   // Shards summing to 2^64 - 16, the last 15 units still fit
+   for ( uint32_t i = 0; i < constants::supply_shards; i++ )
+      mock::set_object( shard_key( i ), supply_object( ( uint64_t( 1 ) << 60 ) - 1 ) );
+   supply = std::numeric_limits< uint64_t >::max() - 15;
+   ok &= expect_supply( "supply near the limit", supply );
+
+   mock::set_caller( "", chain::privilege::kernel_mode );
+   ok &= expect( "mint up to 2^64 - 1", mint( minter, 15 ) == 0 );
+   ok &= expect_supply( "supply at the limit", std::numeric_limits< uint64_t >::max() );
+   ok &= expect( "mint past 2^64 - 1 reverts", mint( minter, 1 ) != 0 );
+   ok &= expect_supply( "supply unchanged", std::numeric_limits< uint64_t >::max() );
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+# Declares a system contract target.
+#
+# By default contracts are wasm32 executables linked against the CDT. When
+# BUILD_FOR_HOST is enabled they are instead built as native loadable modules
+# linked against koinos_syscall_mock so their main() can be driven in-process.
+#
+# With BUILD_WITH_METRICS every contract also links the system call meter, and
+# with BUILD_WITH_ARENA the bump arena allocator. Host builds without the arena
+# also build the contracts in KOINOS_ARENA_BENCH_CONTRACTS as <name>_arena
+# modules, so bench/contract_bench can compare heap allocations both ways.
+#
+# When the contract directory has a <name>.abi, its dispatch entries are
+# generated into <name>_abi.hpp (see cmake/abi_dispatch.py) and the header is
+# made available to the contract.
+#
+# With BUILD_OPTIMIZED_ARTIFACTS the contracts in KOINOS_OPTIMIZED_CONTRACTS
+# are also built as <name>_size and <name>_speed: LTO linked and passed through
+# wasm-opt into <name>_size.opt.wasm and <name>_speed.opt.wasm.
+# add_koinos_contract_report() then compares them against the regular build.
+#
+# Python 3 runs both generators, so it is only required by contracts with an
+# .abi and by BUILD_OPTIMIZED_ARTIFACTS.
+
+find_package(Python3 COMPONENTS Interpreter)
+
+set(KOINOS_OPTIMIZED_CONTRACTS koin resources pow add_thunk)
+set(KOINOS_ARENA_BENCH_CONTRACTS koin resources pow)
+
+set(KOINOS_SIZE_COMPILE_OPTIONS -Oz -flto)
+set(KOINOS_SIZE_LINK_FLAGS "-flto -Wl,--lto-O2")
+set(KOINOS_SIZE_WASM_OPT_FLAGS -Oz --converge --strip-debug --strip-producers)
+
+set(KOINOS_SPEED_COMPILE_OPTIONS -O3 -flto)
+set(KOINOS_SPEED_LINK_FLAGS "-flto -Wl,--lto-O3")
+set(KOINOS_SPEED_WASM_OPT_FLAGS -O3 --strip-debug --strip-producers)
+
+if(BUILD_OPTIMIZED_ARTIFACTS)
+   find_program(WASM_OPT wasm-opt)
+   if(NOT WASM_OPT)
+      message(FATAL_ERROR "BUILD_OPTIMIZED_ARTIFACTS requires wasm-opt from binaryen")
+   endif()
+   if(NOT Python3_Interpreter_FOUND)
+      message(FATAL_ERROR "BUILD_OPTIMIZED_ARTIFACTS requires a Python 3 interpreter")
+   endif()
+endif()
+
+function(koinos_wasm_contract target)
+   set(sources ${ARGN})
+   if(BUILD_WITH_METRICS)
+      list(APPEND sources ${CMAKE_SOURCE_DIR}/src/metrics.cpp)
+   endif()
+   if(BUILD_WITH_ARENA)
+      list(APPEND sources ${CMAKE_SOURCE_DIR}/src/arena.cpp)
+   endif()
+   add_executable(${target} ${sources})
+   target_link_libraries(${target} koinos_proto_embedded koinos_api koinos_api_cpp koinos_wasi_api c c++ c++abi clang_rt.builtins-wasm32)
+endfunction()
+
+function(koinos_host_contract target with_arena)
+   set(sources ${ARGN})
+   if(with_arena)
+      list(APPEND sources ${CMAKE_SOURCE_DIR}/src/arena.cpp)
+   endif()
+   add_library(${target} MODULE ${sources})
+   target_link_libraries(${target} koinos_syscall_mock)
+   if(with_arena)
+      target_compile_definitions(${target} PRIVATE BUILD_WITH_ARENA)
+   endif()
+   # Keep each contract's globals bound to its own module when several are loaded
+   set_target_properties(${target} PROPERTIES PREFIX "" SUFFIX ".so" LINK_FLAGS "-Wl,-Bsymbolic")
+endfunction()
+
+function(add_koinos_contract name)
+   if(BUILD_FOR_HOST)
+      koinos_host_contract(${name} ${BUILD_WITH_ARENA} ${ARGN})
+   else()
+      koinos_wasm_contract(${name} ${ARGN})
+   endif()
+
+   set(targets ${name})
+   add_dependencies(${name} koinos_contract_protos)
+
+   if(BUILD_FOR_HOST AND NOT BUILD_WITH_ARENA AND name IN_LIST KOINOS_ARENA_BENCH_CONTRACTS)
+      koinos_host_contract(${name}_arena ON ${ARGN})
+      add_dependencies(${name}_arena koinos_contract_protos)
+      list(APPEND targets ${name}_arena)
+   endif()
+
+   if(BUILD_OPTIMIZED_ARTIFACTS AND name IN_LIST KOINOS_OPTIMIZED_CONTRACTS)
+      foreach(variant size speed)
+         string(TOUPPER ${variant} VARIANT)
+         set(target ${name}_${variant})
+
+         koinos_wasm_contract(${target} ${ARGN})
+         add_dependencies(${target} koinos_contract_protos)
+         target_compile_options(${target} PRIVATE ${KOINOS_${VARIANT}_COMPILE_OPTIONS})
+         set_target_properties(${target} PROPERTIES LINK_FLAGS "${KOINOS_${VARIANT}_LINK_FLAGS}")
+         add_custom_command(TARGET ${target} POST_BUILD
+            COMMAND ${WASM_OPT} ${KOINOS_${VARIANT}_WASM_OPT_FLAGS} $<TARGET_FILE:${target}> -o $<TARGET_FILE_DIR:${target}>/${target}.opt.wasm
+            COMMENT "Optimizing ${target}")
+
+         list(APPEND targets ${target})
+         set_property(GLOBAL APPEND PROPERTY KOINOS_CONTRACT_ARTIFACTS
+            "${name}:baseline=$<TARGET_FILE:${name}>"
+            "${name}:${variant}=$<TARGET_FILE_DIR:${target}>/${target}.opt.wasm")
+         set_property(GLOBAL APPEND PROPERTY KOINOS_CONTRACT_ARTIFACT_TARGETS ${target})
+      endforeach()
+   endif()
+
+   set(abi ${CMAKE_CURRENT_SOURCE_DIR}/${name}.abi)
+   if(EXISTS ${abi})
+      if(NOT Python3_Interpreter_FOUND)
+         message(FATAL_ERROR "Generating ${name} dispatch entries from ${name}.abi requires a Python 3 interpreter")
+      endif()
+
+      set(abi_header ${CMAKE_CURRENT_BINARY_DIR}/${name}_abi.hpp)
+      add_custom_command(
+         OUTPUT ${abi_header}
+         COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/cmake/abi_dispatch.py ${name} ${abi} ${abi_header}
+         DEPENDS ${abi} ${CMAKE_SOURCE_DIR}/cmake/abi_dispatch.py
+         COMMENT "Generating ${name} dispatch entries from ${name}.abi")
+      add_custom_target(${name}_abi DEPENDS ${abi_header})
+
+      foreach(target ${targets})
+         add_dependencies(${target} ${name}_abi)
+         target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+      endforeach()
+   endif()
+endfunction()
+
+# Writes contract_report.txt, comparing the size, exported and defined function
+# counts and code instruction counts of every optimized artifact variant
+function(add_koinos_contract_report)
+   get_property(artifacts GLOBAL PROPERTY KOINOS_CONTRACT_ARTIFACTS)
+   get_property(artifact_targets GLOBAL PROPERTY KOINOS_CONTRACT_ARTIFACT_TARGETS)
+   list(REMOVE_DUPLICATES artifacts)
+
+   add_custom_target(contract_report ALL
+      COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/cmake/wasm_report.py -o ${CMAKE_BINARY_DIR}/contract_report.txt ${artifacts}
+      COMMENT "Comparing contract artifact variants")
+   add_dependencies(contract_report ${artifact_targets})
+endfunction()
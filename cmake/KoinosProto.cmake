@@ -0,0 +1,55 @@
+# Generates the EmbeddedProto headers for the protos under proto/.
+#
+# proto/ holds the complete koin and resources contract protos, including the
+# messages this tree adds that are not yet in a koinos-proto release. Their
+# headers are generated into the build directory and searched before those of
+# koinos-proto-embedded-cpp, so koinos/contracts/koin/koin.h and
+# koinos/contracts/resources/resources.h resolve to the in-tree definitions.
+#
+# Generation runs protoc with the EmbeddedProto plugin from the
+# koinos-proto-embedded-cpp checkout. The protos import koinos/options.proto,
+# which is taken from a koinos-proto checkout.
+
+set(KOINOS_PROTO_EMBEDDED_DIR "" CACHE PATH "Path to a koinos-proto-embedded-cpp checkout")
+set(KOINOS_PROTO_DIR "" CACHE PATH "Path to a koinos-proto checkout")
+set(EMBEDDED_PROTO_PLUGIN "${KOINOS_PROTO_EMBEDDED_DIR}/EmbeddedProto/protoc-gen-eams" CACHE FILEPATH "EmbeddedProto protoc plugin")
+
+set(KOINOS_CONTRACT_PROTOS
+   koinos/contracts/koin/koin.proto
+   koinos/contracts/resources/resources.proto)
+
+find_program(PROTOC protoc)
+if(NOT PROTOC)
+   message(FATAL_ERROR "Generating the contract protos requires protoc")
+endif()
+
+if(NOT EXISTS "${EMBEDDED_PROTO_PLUGIN}")
+   message(FATAL_ERROR "Generating the contract protos requires EMBEDDED_PROTO_PLUGIN or KOINOS_PROTO_EMBEDDED_DIR to locate the EmbeddedProto plugin")
+endif()
+
+if(NOT EXISTS "${KOINOS_PROTO_DIR}/koinos/options.proto")
+   message(FATAL_ERROR "Generating the contract protos requires KOINOS_PROTO_DIR to point at koinos-proto")
+endif()
+
+set(KOINOS_PROTO_OUTPUT_DIR ${CMAKE_BINARY_DIR}/proto)
+
+foreach(proto ${KOINOS_CONTRACT_PROTOS})
+   string(REGEX REPLACE "\\.proto$" ".h" header ${proto})
+   add_custom_command(
+      OUTPUT ${KOINOS_PROTO_OUTPUT_DIR}/${header}
+      COMMAND ${CMAKE_COMMAND} -E make_directory ${KOINOS_PROTO_OUTPUT_DIR}
+      COMMAND ${PROTOC}
+         --plugin=protoc-gen-eams=${EMBEDDED_PROTO_PLUGIN}
+         -I${CMAKE_SOURCE_DIR}/proto
+         -I${KOINOS_PROTO_DIR}
+         --eams_out=${KOINOS_PROTO_OUTPUT_DIR}
+         ${proto}
+      DEPENDS ${CMAKE_SOURCE_DIR}/proto/${proto}
+      WORKING_DIRECTORY ${CMAKE_SOURCE_DIR}/proto
+      COMMENT "Generating ${header}")
+   list(APPEND KOINOS_PROTO_HEADERS ${KOINOS_PROTO_OUTPUT_DIR}/${header})
+endforeach()
+
+add_custom_target(koinos_contract_protos DEPENDS ${KOINOS_PROTO_HEADERS})
+
+include_directories(BEFORE ${KOINOS_PROTO_OUTPUT_DIR})
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+
+# Generates the dispatch entries for a contract from its .abi file.
+#
+# Every method becomes a koinos::contracts::dispatch::entry carrying its entry
+# point id and read-only flag, in namespace koinos::contracts::abi::<contract>.
+# Entry points are taken from the .abi as published rather than derived from
+# the method name, since some deployed ids do not follow sha256( name ). A
+# malformed or duplicated id fails the build.
+#
+# usage: abi_dispatch.py <contract> <abi file> <output header>
+
+import json
+import sys
+
+
+def main( contract, abi_path, out_path ):
+   with open( abi_path ) as f:
+      methods = json.load( f )['methods']
+
+   width = max( len( name ) for name in methods )
+   lines = []
+   seen = {}
+
+   for name, method in methods.items():
+      entry = int( method['entry-point'], 16 )
+      if entry >> 32:
+         sys.exit( '{}: method {} entry point {} does not fit in 32 bits'.format( abi_path, name, method['entry-point'] ) )
+      if entry in seen:
+         sys.exit( '{}: methods {} and {} share entry point {:#010x}'.format( abi_path, seen[entry], name, entry ) )
+      seen[entry] = name
+
+      lines.append( 'inline constexpr dispatch::entry {} = {{ {:#010x}, {} }};'.format(
+         name.ljust( width ), entry, 'true' if method['read-only'] else 'false' ) )
+
+   header = '\n'.join( [
+      '// Generated from {} by cmake/abi_dispatch.py, do not edit'.format( abi_path.split( '/' )[-1] ),
+      '',
+      '#pragma once',
+      '',
+      '#include <koinos/contracts/dispatch.hpp>',
+      '',
+      '#include <array>',
+      '',
+      'namespace koinos::contracts::abi::{} {{'.format( contract ),
+      '',
+      *lines,
+      '',
+      'inline constexpr std::array< dispatch::entry, {} > methods = {{ {} }};'.format( len( methods ), ', '.join( methods ) ),
+      '',
+      '}} // koinos::contracts::abi::{}'.format( contract ),
+      ''
+   ] )
+
+   with open( out_path, 'w' ) as f:
+      f.write( header )
+
+
+if __name__ == '__main__':
+   if len( sys.argv ) != 4:
+      sys.exit( 'usage: abi_dispatch.py <contract> <abi file> <output header>' )
+   main( *sys.argv[1:] )
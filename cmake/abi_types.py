@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+
+# Regenerates the type descriptor of a contract's .abi file from a proto.
+#
+# The "types" field of an .abi is a base64 FileDescriptorSet. The proto given is
+# compiled with protoc and its file descriptor replaces the one of the same
+# name in the set, or is appended to it. Other files in the set, such as the
+# token proto the koin .abi also carries, are left as they are.
+#
+# usage: abi_types.py <abi file> <proto> -I <proto path> [-I <proto path> ...]
+
+import argparse
+import base64
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def varint( data, pos ):
+   value = 0
+   shift = 0
+   while True:
+      b = data[pos]
+      pos += 1
+      value |= ( b & 0x7f ) << shift
+      shift += 7
+      if not b & 0x80:
+         return value, pos
+
+
+def encode_varint( value ):
+   out = bytearray()
+   while True:
+      b = value & 0x7f
+      value >>= 7
+      if value:
+         out.append( b | 0x80 )
+      else:
+         out.append( b )
+         return bytes( out )
+
+
+# Splits a FileDescriptorSet into its file descriptors, which are field 1
+def files( data ):
+   out = []
+   pos = 0
+   while pos < len( data ):
+      key, pos = varint( data, pos )
+      if key != 0x0a:
+         sys.exit( 'unexpected field {:#x} in descriptor set'.format( key ) )
+      size, pos = varint( data, pos )
+      out.append( data[pos:pos + size] )
+      pos += size
+   return out
+
+
+# The name of a file descriptor, which is its field 1
+def name( file ):
+   for key, value in fields( file ):
+      if key == 0x0a:
+         return value.decode()
+   sys.exit( 'file descriptor without a name' )
+
+
+def fields( data ):
+   pos = 0
+   while pos < len( data ):
+      key, pos = varint( data, pos )
+      wire = key & 7
+      if wire == 0:
+         value, pos = varint( data, pos )
+      elif wire == 2:
+         size, pos = varint( data, pos )
+         value = data[pos:pos + size]
+         pos += size
+      elif wire == 1:
+         value = data[pos:pos + 8]
+         pos += 8
+      elif wire == 5:
+         value = data[pos:pos + 4]
+         pos += 4
+      else:
+         sys.exit( 'unexpected wire type {} in file descriptor'.format( wire ) )
+      yield key, value
+
+
+def main():
+   parser = argparse.ArgumentParser()
+   parser.add_argument( 'abi' )
+   parser.add_argument( 'proto' )
+   parser.add_argument( '-I', dest = 'paths', action = 'append', default = [] )
+   args = parser.parse_args()
+
+   with open( args.abi ) as f:
+      abi = f.read()
+   types = json.loads( abi )['types']
+
+   with tempfile.TemporaryDirectory() as tmp:
+      out = os.path.join( tmp, 'descriptor.pb' )
+      subprocess.run( [ 'protoc' ] + [ '-I' + p for p in args.paths ] + [ '--descriptor_set_out=' + out, args.proto ], check = True )
+      with open( out, 'rb' ) as f:
+         generated = files( f.read() )
+
+   descriptors = files( base64.b64decode( types ) )
+   for g in generated:
+      names = [ name( f ) for f in descriptors ]
+      if name( g ) in names:
+         descriptors[ names.index( name( g ) ) ] = g
+      else:
+         descriptors.append( g )
+
+   descriptor = b''.join( b'\x0a' + encode_varint( len( f ) ) + f for f in descriptors )
+
+   # Only the types value is replaced so the rest of the file keeps its layout
+   with open( args.abi, 'w' ) as f:
+      f.write( abi.replace( types, base64.b64encode( descriptor ).decode() ) )
+
+
+if __name__ == '__main__':
+   main()
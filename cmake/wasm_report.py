@@ -0,0 +1,192 @@
+#!/usr/bin/env python3
+
+# Compares contract artifact variants side by side.
+#
+# For every module the report lists its size, the number of exported and
+# defined functions, and the number of instructions in its code section. Each
+# artifact is given as <contract>:<variant>=<path>, and variants of the same
+# contract are printed next to each other with their size relative to the
+# first variant listed.
+#
+# usage: wasm_report.py [-o <report file>] <contract>:<variant>=<path> ...
+
+import argparse
+import collections
+import os
+import sys
+
+SIMPLE_BLOCK_TYPES = { 0x40, 0x7f, 0x7e, 0x7d, 0x7c, 0x7b, 0x70, 0x6f }
+
+
+class reader:
+   def __init__( self, data, pos = 0, end = None ):
+      self.data = data
+      self.pos  = pos
+      self.end  = len( data ) if end is None else end
+
+   def done( self ):
+      return self.pos >= self.end
+
+   def byte( self ):
+      b = self.data[self.pos]
+      self.pos += 1
+      return b
+
+   def skip( self, n ):
+      self.pos += n
+
+   def uleb( self ):
+      result, shift = 0, 0
+      while True:
+         b = self.byte()
+         result |= ( b & 0x7f ) << shift
+         shift += 7
+         if not b & 0x80:
+            return result
+
+   def sleb( self ):
+      result, shift = 0, 0
+      while True:
+         b = self.byte()
+         result |= ( b & 0x7f ) << shift
+         shift += 7
+         if not b & 0x80:
+            if b & 0x40:
+               result -= 1 << shift
+            return result
+
+
+def skip_immediates( r, op ):
+   if op in ( 0x02, 0x03, 0x04 ):
+      if r.data[r.pos] in SIMPLE_BLOCK_TYPES:
+         r.skip( 1 )
+      else:
+         r.sleb()
+   elif op in ( 0x0c, 0x0d, 0x10, 0x12, 0xd2 ) or 0x20 <= op <= 0x26:
+      r.uleb()
+   elif op == 0x0e:
+      for _ in range( r.uleb() + 1 ):
+         r.uleb()
+   elif op in ( 0x11, 0x13 ):
+      r.uleb()
+      r.uleb()
+   elif op == 0x1c:
+      r.skip( r.uleb() )
+   elif 0x28 <= op <= 0x3e:
+      r.uleb()
+      r.uleb()
+   elif op in ( 0x3f, 0x40, 0xd0 ):
+      r.skip( 1 )
+   elif op in ( 0x41, 0x42 ):
+      r.sleb()
+   elif op == 0x43:
+      r.skip( 4 )
+   elif op == 0x44:
+      r.skip( 8 )
+   elif op == 0xfc:
+      sub = r.uleb()
+      if sub == 8:
+         r.uleb()
+         r.skip( 1 )
+      elif sub in ( 12, 14 ):
+         r.uleb()
+         r.uleb()
+      elif sub == 10:
+         r.skip( 2 )
+      elif sub == 11:
+         r.skip( 1 )
+      elif sub in ( 9, 13, 15, 16, 17 ):
+         r.uleb()
+   elif op == 0xfd:
+      raise ValueError( 'SIMD instructions are not supported' )
+   elif not ( op <= 0x01 or op in ( 0x05, 0x0b, 0x0f, 0x1a, 0x1b, 0xd1 ) or 0x45 <= op <= 0xc4 ):
+      raise ValueError( 'unknown opcode {:#04x}'.format( op ) )
+
+
+def count_instructions( r ):
+   count = 0
+   for _ in range( r.uleb() ):
+      size = r.uleb()
+      body = reader( r.data, r.pos, r.pos + size )
+      r.skip( size )
+
+      for _ in range( body.uleb() ):
+         body.uleb()
+         body.skip( 1 )
+
+      while not body.done():
+         op = body.byte()
+         skip_immediates( body, op )
+         count += 1
+
+   return count
+
+
+def analyze( path ):
+   with open( path, 'rb' ) as f:
+      data = f.read()
+
+   if data[:4] != b'\0asm':
+      raise ValueError( '{} is not a wasm module'.format( path ) )
+
+   stats = { 'bytes': len( data ), 'exports': 0, 'functions': 0, 'instructions': 0 }
+   r = reader( data, 8 )
+
+   while not r.done():
+      section = r.byte()
+      size = r.uleb()
+      s = reader( data, r.pos, r.pos + size )
+      r.skip( size )
+
+      if section == 3:
+         stats['functions'] = s.uleb()
+      elif section == 7:
+         for _ in range( s.uleb() ):
+            s.skip( s.uleb() )
+            kind = s.byte()
+            s.uleb()
+            if kind == 0:
+               stats['exports'] += 1
+      elif section == 10:
+         stats['instructions'] = count_instructions( s )
+
+   return stats
+
+
+def main():
+   parser = argparse.ArgumentParser( description = 'Compare contract artifact variants' )
+   parser.add_argument( '-o', '--output', help = 'also write the report to this file' )
+   parser.add_argument( 'artifacts', nargs = '+', metavar = '<contract>:<variant>=<path>' )
+   args = parser.parse_args()
+
+   contracts = collections.OrderedDict()
+   for artifact in args.artifacts:
+      name, path = artifact.split( '=', 1 )
+      contract, variant = name.split( ':', 1 )
+      contracts.setdefault( contract, [] ).append( ( variant, path ) )
+
+   lines = [ '{:<12} {:<10} {:>10} {:>8} {:>9} {:>10} {:>13}'.format(
+      'contract', 'variant', 'bytes', 'size', 'exports', 'functions', 'instructions' ) ]
+
+   for contract, variants in contracts.items():
+      base = None
+      for variant, path in variants:
+         if not os.path.exists( path ):
+            sys.exit( 'missing artifact {}'.format( path ) )
+
+         stats = analyze( path )
+         base = base or stats['bytes']
+         lines.append( '{:<12} {:<10} {:>10} {:>7.1f}% {:>9} {:>10} {:>13}'.format(
+            contract, variant, stats['bytes'], 100.0 * stats['bytes'] / base,
+            stats['exports'], stats['functions'], stats['instructions'] ) )
+
+   report = '\n'.join( lines ) + '\n'
+   sys.stdout.write( report )
+
+   if args.output:
+      with open( args.output, 'w' ) as f:
+         f.write( report )
+
+
+if __name__ == '__main__':
+   main()
@@ -1,14 +1,19 @@
 #include <koinos/system/system_calls.hpp>
 
+#include <koinos/contracts/context.hpp>
+#include <koinos/contracts/system_calls.hpp>
+
+#include <string_view>
+
 using namespace koinos;
+using namespace koinos::contracts;
 using namespace std::string_literals;
 
 namespace constants {
 
-const uint64_t proposal_space_id       = 0;
-const auto contract_id                 = system::get_contract_id();
-const std::string compute_registry_key = "\x12\x20\xc5\x4f\xe8\x71\xc0\x9e\x87\x25\x0f\xc5\x0f\xd1\x16\xcc\xc3\xe9\xc0\xfd\xdb\x61\x36\x82\x43\x5a\xf5\xa0\x07\xf5\x54\xaf\x87\xc2";
-const std::string thunk_name           = "nop";
+constexpr uint64_t proposal_space_id            = 0;
+constexpr std::string_view compute_registry_key = "\x12\x20\xc5\x4f\xe8\x71\xc0\x9e\x87\x25\x0f\xc5\x0f\xd1\x16\xcc\xc3\xe9\xc0\xfd\xdb\x61\x36\x82\x43\x5a\xf5\xa0\x07\xf5\x54\xaf\x87\xc2";
+constexpr std::string_view thunk_name           = "nop";
 
 } // constants
 
@@ -19,7 +24,8 @@ namespace detail {
 system::object_space create_called_space()
 {
    system::object_space called_space;
-   called_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( constants::contract_id.data() ), constants::contract_id.size() );
+   const auto& contract_id = context::contract_id();
+   called_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
    called_space.set_id( constants::proposal_space_id );
    called_space.set_system( true );
    return called_space;
@@ -1,4 +1,5 @@
 #include <koinos/system/system_calls.hpp>
+#include <cstring>
 #include <limits>
 using namespace koinos;
 
@@ -1,46 +1,67 @@
 #include <koinos/contracts.hpp>
 #include <koinos/system/system_calls.hpp>
 
+#include <koinos/contracts/balance_record.hpp>
+#include <koinos/contracts/context.hpp>
+#include <koinos/contracts/dispatch.hpp>
+#include <koinos/contracts/integer.hpp>
+#include <koinos/contracts/system_calls.hpp>
+
 #include <koinos/chain/authority.h>
 #include <koinos/contracts/koin/koin.h>
 #include <koinos/contracts/token/token.h>
 
+#include <koin_abi.hpp>
+
 #include <koinos/buffer.hpp>
 #include <koinos/common.h>
 
-#include <boost/multiprecision/cpp_int.hpp>
-
+#include <algorithm>
+#include <array>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <vector>
 
 using namespace koinos;
 using namespace koinos::contracts;
 
 using namespace std::string_literals;
 
-using int128_t = boost::multiprecision::int128_t;
-
 namespace constants {
 
 #ifdef BUILD_FOR_TESTING
-static const std::string koinos_name   = "Test Koin";
-static const std::string koinos_symbol = "tKOIN";
+constexpr char koinos_name[]            = "Test Koin";
+constexpr char koinos_symbol[]          = "tKOIN";
 #else
-static const std::string koinos_name   = "Koin";
-static const std::string koinos_symbol = "KOIN";
+constexpr char koinos_name[]            = "Koin";
+constexpr char koinos_symbol[]          = "KOIN";
 #endif
-constexpr uint32_t koinos_decimals     = 8;
-constexpr uint64_t mana_regen_time_ms  = 432'000'000; // 5 days
-constexpr std::size_t max_address_size = 25;
-constexpr std::size_t max_name_size    = 32;
-constexpr std::size_t max_symbol_size  = 8;
-constexpr std::size_t max_buffer_size  = 2048;
-constexpr uint32_t supply_id           = 0;
-constexpr uint32_t balance_id          = 1;
-std::string supply_key                 = "";
-const auto contract_id                 = system::get_contract_id();
+constexpr uint32_t koinos_decimals      = 8;
+constexpr uint64_t mana_regen_time_ms   = 432'000'000; // 5 days
+constexpr std::size_t max_address_size  = 25;
+constexpr std::size_t max_name_size     = 32;
+constexpr std::size_t max_symbol_size   = 8;
+constexpr std::size_t max_buffer_size   = 2048;
+constexpr std::size_t max_batch_size    = 64;
+constexpr std::size_t max_rc_batch_size = 128;
+constexpr std::size_t max_access_args   = 128;
+constexpr uint32_t supply_shards        = 16;
+constexpr std::size_t max_access_set    = supply_shards + 2;
+constexpr uint32_t supply_id            = 0;
+constexpr uint32_t balance_id           = 1;
+constexpr std::string_view supply_key   = ""; // Supply from before sharding
 
 } // constants
 
+namespace events {
+
+constexpr std::string_view transfer = "koinos.contracts.token.transfer_event";
+constexpr std::string_view mint     = "koinos.contracts.token.mint_event";
+constexpr std::string_view burn     = "koinos.contracts.token.burn_event";
+
+} // events
+
 namespace state {
 
 namespace detail {
@@ -48,7 +69,8 @@ namespace detail {
 system::object_space create_supply_space()
 {
    system::object_space supply_space;
-   supply_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( constants::contract_id.data() ), constants::contract_id.size() );
+   const auto& contract_id = context::contract_id();
+   supply_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
    supply_space.set_id( constants::supply_id );
    supply_space.set_system( true );
    return supply_space;
@@ -57,12 +79,22 @@ system::object_space create_supply_space()
 system::object_space create_balance_space()
 {
    system::object_space balance_space;
-   balance_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( constants::contract_id.data() ), constants::contract_id.size() );
+   const auto& contract_id = context::contract_id();
+   balance_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
    balance_space.set_id( constants::balance_id );
    balance_space.set_system( true );
    return balance_space;
 }
 
+// Shard keys are the single byte shard index
+constexpr auto supply_shard_keys = []()
+{
+   std::array< char, constants::supply_shards > keys = {};
+   for ( uint32_t i = 0; i < constants::supply_shards; i++ )
+      keys[i] = char( i );
+   return keys;
+}();
+
 } // detail
 
 const system::object_space& supply_space()
@@ -77,24 +109,132 @@ const system::object_space& balance_space()
    return balance_space;
 }
 
-} // state
+// Balances are read in either layout, protobuf encoded mana_balance_object or
+// balance_record, so a build can take over state written by the other kind.
+// Records are written unless BUILD_WITH_BALANCE_RECORDS is turned off, so
+// deploying this KOIN upgrades every account to a record as it is next written.
+// That is a state format change that has to be activated with the contract
+// upgrade (see README.md).
+balance_record get_balance( std::string_view owner )
+{
+   auto obj = system::detail::get_object( balance_space(), owner );
+   if ( balance_record::is_record( obj ) )
+      return balance_record::from_bytes( obj );
+
+   balance_record rec;
+   if ( obj.size() )
+   {
+      koin::mana_balance_object bal_obj;
+      koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( obj.data() ), obj.size() );
+      bal_obj.deserialize( rdbuf );
+
+      rec.set_balance( bal_obj.balance() );
+      rec.set_mana( bal_obj.mana() );
+      rec.set_last_mana_update( bal_obj.last_mana_update() );
+   }
+
+   return rec;
+}
+
+void put_balance( std::string_view owner, const balance_record& rec )
+{
+#ifdef BUILD_WITH_BALANCE_RECORDS
+   system::detail::put_object( balance_space(), owner, rec.bytes() );
+#else
+   koin::mana_balance_object bal_obj;
+   bal_obj.set_balance( rec.balance() );
+   bal_obj.set_mana( rec.mana() );
+   bal_obj.set_last_mana_update( rec.last_mana_update() );
+   system::put_object( balance_space(), owner, bal_obj );
+#endif
+}
+
+// Supply is split over supply_shards counters so mints and burns do not all
+// write one object. A mint or burn updates the signed delta of the shard its
+// account hashes to, and total supply is the exact sum of every delta and of
+// the supply written before sharding. That legacy object is folded into a
+// shard by the first mint after the upgrade and removed.
+uint32_t supply_shard( std::string_view owner )
+{
+   // FNV-1a
+   uint32_t h = 0x811c9dc5;
+   for ( unsigned char c : owner )
+   {
+      h ^= c;
+      h *= 0x01000193;
+   }
+   return h % constants::supply_shards;
+}
+
+std::string_view supply_shard_key( uint32_t shard )
+{
+   return std::string_view( &detail::supply_shard_keys[ shard ], 1 );
+}
+
+bool has_legacy_supply()
+{
+   return system::detail::get_object( supply_space(), constants::supply_key ).size();
+}
+
+// Deltas are stored two's complement in the balance object's value
+int64_t get_supply_delta( uint32_t shard )
+{
+   token::balance_object supply_obj;
+   system::get_object( supply_space(), supply_shard_key( shard ), supply_obj );
+   return int64_t( supply_obj.get_value() );
+}
+
+void put_supply_delta( uint32_t shard, int64_t delta )
+{
+   token::balance_object supply_obj;
+   supply_obj.set_value( uint64_t( delta ) );
+   system::put_object( supply_space(), supply_shard_key( shard ), supply_obj );
+}
+
+struct supply_counters
+{
+   bool                                            has_legacy = false;
+   uint64_t                                        legacy     = 0;
+   std::array< int64_t, constants::supply_shards > deltas     = {};
+
+   // Shards may be negative, the total never is and always fits in 64 bits
+   uint64_t total() const
+   {
+      __int128 sum = legacy;
+      for ( auto delta : deltas )
+         sum += delta;
 
-enum entries : uint32_t
-{
-   get_account_rc_entry     = 0x2d464aab,
-   consume_account_rc_entry = 0x80e3f5c9,
-   name_entry               = 0x82a3537f,
-   symbol_entry             = 0xb76a7ca1,
-   decimals_entry           = 0xee80fd2f,
-   total_supply_entry       = 0xb0da3934,
-   balance_of_entry         = 0x5c721497,
-   transfer_entry           = 0x27f576ca,
-   mint_entry               = 0xdc6f17bb,
-   burn_entry               = 0x859facc5,
-   authorize_entry          = 0x4a2dbd90
+      if ( sum < 0 || sum > __int128( std::numeric_limits< uint64_t >::max() ) )
+         system::revert( "supply out of range" );
+
+      return uint64_t( sum );
+   }
 };
 
-std::string arguments; // Declared globally to pass to check_authority
+supply_counters get_supply_counters()
+{
+   supply_counters counters;
+
+   token::balance_object supply_obj;
+   counters.has_legacy = system::get_object( supply_space(), constants::supply_key, supply_obj );
+   counters.legacy = supply_obj.get_value();
+
+   for ( uint32_t i = 0; i < constants::supply_shards; i++ )
+      counters.deltas[i] = get_supply_delta( i );
+
+   return counters;
+}
+
+} // state
+
+// Kernel-only entries, these are not published in koin.abi
+namespace entries {
+
+inline constexpr dispatch::entry get_account_rc            = { 0x2d464aab, true };
+inline constexpr dispatch::entry consume_account_rc        = { 0x80e3f5c9, false };
+inline constexpr dispatch::entry consume_accounts_rc_batch = { 0xf0547634, false };
+
+} // entries
 
 using get_account_rc_arguments
    = chain::get_account_rc_arguments<
@@ -106,13 +246,46 @@ using consume_account_rc_arguments
       constants::max_name_size
    >;
 
-void regenerate_mana( koin::mana_balance_object& bal )
+using consume_accounts_rc_batch_arguments
+   = koin::consume_accounts_rc_batch_arguments<
+      constants::max_rc_batch_size,
+      constants::max_name_size
+   >;
+
+using consume_accounts_rc_batch_result
+   = koin::consume_accounts_rc_batch_result<
+      constants::max_rc_batch_size
+   >;
+
+using transfer_batch_arguments
+   = koin::transfer_batch_arguments<
+      constants::max_address_size,
+      constants::max_batch_size,
+      constants::max_address_size
+   >;
+
+using access_key = koin::access_key< constants::max_name_size >;
+
+using get_access_set_arguments
+   = koin::get_access_set_arguments<
+      constants::max_access_args
+   >;
+
+using get_access_set_result
+   = koin::get_access_set_result<
+      constants::max_access_set,
+      constants::max_name_size,
+      constants::max_access_set,
+      constants::max_name_size
+   >;
+
+void regenerate_mana( balance_record& bal )
 {
-   auto head_block_time = system::get_head_info().head_block_time();
+   auto head_block_time = context::head_block_time();
    auto delta = std::min( head_block_time - bal.last_mana_update(), constants::mana_regen_time_ms );
    if ( delta )
    {
-      auto new_mana = bal.mana() + ( ( int128_t( delta ) * int128_t( bal.balance() ) ) / constants::mana_regen_time_ms ).convert_to< uint64_t >() ;
+      auto new_mana = bal.mana() + mul_div< constants::mana_regen_time_ms >( delta, bal.balance() );
       bal.set_mana( std::min( new_mana, bal.balance() ) );
       bal.set_last_mana_update( head_block_time );
    }
@@ -120,7 +293,7 @@ void regenerate_mana( koin::mana_balance_object& bal )
 
 chain::get_account_rc_result get_account_rc( const get_account_rc_arguments& args )
 {
-   std::string owner( reinterpret_cast< const char* >( args.get_account().get_const() ), args.get_account().get_length() );
+   auto owner = view( args.get_account() );
    chain::get_account_rc_result res;
 
    if ( owner == contracts::governance_address() )
@@ -129,8 +302,7 @@ chain::get_account_rc_result get_account_rc( const get_account_rc_arguments& arg
       return res;
    }
 
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
+   auto bal_obj = state::get_balance( owner );
 
    regenerate_mana( bal_obj );
 
@@ -143,16 +315,15 @@ chain::consume_account_rc_result consume_account_rc( const consume_account_rc_ar
    chain::consume_account_rc_result res;
    res.set_value( false );
 
-   const auto [caller, privilege] = system::get_caller();
+   const auto& [caller, privilege] = context::caller();
    if ( privilege != chain::privilege::kernel_mode )
    {
       system::log( "The system call consume_account_rc must be called from kernel context" );
       return res;
    }
 
-   std::string owner( reinterpret_cast< const char* >( args.get_account().get_const() ), args.get_account().get_length() );
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
+   auto owner = view( args.get_account() );
+   auto bal_obj = state::get_balance( owner );
 
    regenerate_mana( bal_obj );
 
@@ -165,23 +336,81 @@ chain::consume_account_rc_result consume_account_rc( const consume_account_rc_ar
 
    bal_obj.set_mana( bal_obj.mana() - args.value() );
 
-   system::put_object( state::balance_space(), owner, bal_obj );
+   state::put_balance( owner, bal_obj );
 
    res.set_value( true );
    return res;
 }
 
+// Settles the RC of every transaction in a block. Charges are applied in
+// order, as consecutive consume_account_rc calls would, but each payer is read,
+// regenerated and written once.
+consume_accounts_rc_batch_result consume_accounts_rc_batch( const consume_accounts_rc_batch_arguments& args )
+{
+   consume_accounts_rc_batch_result res;
+   const auto& entries = args.get_entries();
+
+   const auto& [caller, privilege] = context::caller();
+   if ( privilege != chain::privilege::kernel_mode )
+   {
+      system::log( "The system call consume_accounts_rc_batch must be called from kernel context" );
+      for ( uint32_t i = 0; i < entries.get_length(); i++ )
+         res.add_value( false );
+      return res;
+   }
+
+   struct payer
+   {
+      std::string_view          account;
+      balance_record            balance;
+      bool                      charged;
+   };
+
+   std::vector< payer > payers;
+   payers.reserve( entries.get_length() );
+
+   for ( uint32_t i = 0; i < entries.get_length(); i++ )
+   {
+      const auto& entry = entries[i];
+      auto account = view( entry.get_account() );
+
+      auto p = std::find_if( payers.begin(), payers.end(), [&]( const auto& p ) { return p.account == account; } );
+      if ( p == payers.end() )
+      {
+         auto bal_obj = state::get_balance( account );
+         regenerate_mana( bal_obj );
+         p = payers.insert( payers.end(), payer{ account, bal_obj, false } );
+      }
+
+      if ( p->balance.mana() < entry.value() )
+      {
+         res.add_value( false );
+         continue;
+      }
+
+      p->balance.set_mana( p->balance.mana() - entry.value() );
+      p->charged = true;
+      res.add_value( true );
+   }
+
+   for ( const auto& p : payers )
+      if ( p.charged )
+         state::put_balance( p.account, p.balance );
+
+   return res;
+}
+
 token::name_result< constants::max_name_size > name()
 {
    token::name_result< constants::max_name_size > res;
-   res.mutable_value() = constants::koinos_name.c_str();
+   res.mutable_value() = constants::koinos_name;
    return res;
 }
 
 token::symbol_result< constants::max_symbol_size > symbol()
 {
    token::symbol_result< constants::max_symbol_size > res;
-   res.mutable_value() = constants::koinos_symbol.c_str();
+   res.mutable_value() = constants::koinos_symbol;
    return res;
 }
 
@@ -195,11 +424,7 @@ token::decimals_result decimals()
 token::total_supply_result total_supply()
 {
    token::total_supply_result res;
-
-   token::balance_object bal_obj;
-   system::get_object( state::supply_space(), constants::supply_key, bal_obj );
-
-   res.mutable_value() = bal_obj.get_value();
+   res.mutable_value() = state::get_supply_counters().total();
    return res;
 }
 
@@ -207,10 +432,9 @@ token::balance_of_result balance_of( const token::balance_of_arguments< constant
 {
    token::balance_of_result res;
 
-   std::string owner( reinterpret_cast< const char* >( args.get_owner().get_const() ), args.get_owner().get_length() );
+   auto owner = view( args.get_owner() );
 
-   koin::mana_balance_object bal_obj;
-   system::get_object( state::balance_space(), owner, bal_obj );
+   auto bal_obj = state::get_balance( owner );
 
    res.set_value( bal_obj.get_balance() );
    return res;
@@ -218,19 +442,18 @@ token::balance_of_result balance_of( const token::balance_of_arguments< constant
 
 token::transfer_result transfer( const token::transfer_arguments< constants::max_address_size, constants::max_address_size >& args )
 {
-   std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
-   std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
+   auto from = view( args.get_from() );
+   auto to = view( args.get_to() );
    uint64_t value = args.get_value();
 
    if ( from == to )
       system::fail( "cannot transfer to self" );
 
-   const auto [ caller, privilege ] = system::get_caller();
-   if ( caller != from && !system::check_authority( from, arguments ) )
+   const auto& [ caller, privilege ] = context::caller();
+   if ( caller != from && !system::check_authority( std::string( from ), dispatch::arguments() ) )
       system::fail( "from has not authorized transfer", chain::error_code::authorization_failure );
 
-   koin::mana_balance_object from_bal_obj;
-   system::get_object( state::balance_space(), from, from_bal_obj );
+   auto from_bal_obj = state::get_balance( from );
 
    if ( from_bal_obj.balance() < value )
       system::fail( "account 'from' has insufficient balance" );
@@ -240,8 +463,7 @@ token::transfer_result transfer( const token::transfer_arguments< constants::max
    if ( from_bal_obj.mana() < value )
       system::fail( "account 'from' has insufficient mana for transfer" );
 
-   koin::mana_balance_object to_bal_obj;
-   system::get_object( state::balance_space(), to, to_bal_obj );
+   auto to_bal_obj = state::get_balance( to );
 
    regenerate_mana( to_bal_obj );
 
@@ -250,81 +472,157 @@ token::transfer_result transfer( const token::transfer_arguments< constants::max
    to_bal_obj.set_balance( to_bal_obj.balance() + value );
    to_bal_obj.set_mana( to_bal_obj.mana() + value );
 
-   system::put_object( state::balance_space(), from, from_bal_obj );
-   system::put_object( state::balance_space(), to, to_bal_obj );
+   state::put_balance( from, from_bal_obj );
+   state::put_balance( to, to_bal_obj );
 
    token::transfer_event< constants::max_address_size, constants::max_address_size > transfer_event;
    transfer_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
    transfer_event.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
    transfer_event.set_value( args.get_value() );
 
-   std::vector< std::string > impacted;
-   impacted.push_back( to );
-   impacted.push_back( from );
-   koinos::system::event( "koinos.contracts.token.transfer_event", transfer_event, impacted );
+   koinos::system::event( events::transfer, transfer_event, { to, from } );
 
    return token::transfer_result();
 }
 
+koin::transfer_batch_result transfer_batch( const transfer_batch_arguments& args )
+{
+   auto from = view( args.get_from() );
+   const auto& transfers = args.get_transfers();
+
+   const auto& [ caller, privilege ] = context::caller();
+   if ( caller != from && !system::check_authority( std::string( from ), dispatch::arguments() ) )
+      system::fail( "from has not authorized transfer", chain::error_code::authorization_failure );
+
+   // Coalesce repeated recipients so each balance is read and written once
+   std::vector< std::pair< std::string_view, uint64_t > > credits;
+   credits.reserve( transfers.get_length() );
+   uint64_t total = 0;
+
+   for ( uint32_t i = 0; i < transfers.get_length(); i++ )
+   {
+      const auto& transfer = transfers[i];
+      auto to = view( transfer.get_to() );
+      uint64_t value = transfer.get_value();
+
+      if ( from == to )
+         system::fail( "cannot transfer to self" );
+
+      if ( total + value < total )
+         system::fail( "transfer batch would overflow" );
+
+      total += value;
+
+      auto credit = std::find_if( credits.begin(), credits.end(), [&]( const auto& c ) { return c.first == to; } );
+      if ( credit == credits.end() )
+         credits.emplace_back( to, value );
+      else
+         credit->second += value;
+   }
+
+   auto from_bal_obj = state::get_balance( from );
+
+   if ( from_bal_obj.balance() < total )
+      system::fail( "account 'from' has insufficient balance" );
+
+   regenerate_mana( from_bal_obj );
+
+   if ( from_bal_obj.mana() < total )
+      system::fail( "account 'from' has insufficient mana for transfer" );
+
+   from_bal_obj.set_balance( from_bal_obj.balance() - total );
+   from_bal_obj.set_mana( from_bal_obj.mana() - total );
+
+   state::put_balance( from, from_bal_obj );
+
+   for ( const auto& [ to, value ] : credits )
+   {
+      auto to_bal_obj = state::get_balance( to );
+
+      regenerate_mana( to_bal_obj );
+
+      to_bal_obj.set_balance( to_bal_obj.balance() + value );
+      to_bal_obj.set_mana( to_bal_obj.mana() + value );
+
+      state::put_balance( to, to_bal_obj );
+   }
+
+   // Each transfer is still reported individually for indexers
+   for ( uint32_t i = 0; i < transfers.get_length(); i++ )
+   {
+      const auto& transfer = transfers[i];
+
+      token::transfer_event< constants::max_address_size, constants::max_address_size > transfer_event;
+      transfer_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
+      transfer_event.mutable_to().set( transfer.get_to().get_const(), transfer.get_to().get_length() );
+      transfer_event.set_value( transfer.get_value() );
+
+      koinos::system::event( events::transfer, transfer_event, { view( transfer.get_to() ), from } );
+   }
+
+   return koin::transfer_batch_result();
+}
+
 token::mint_result mint( const token::mint_arguments< constants::max_address_size >& args )
 {
-   std::string to( reinterpret_cast< const char* >( args.get_to().get_const() ), args.get_to().get_length() );
+   auto to = view( args.get_to() );
    uint64_t amount = args.get_value();
 
-   const auto [ caller, privilege ] = system::get_caller();
+   const auto& [ caller, privilege ] = context::caller();
    if ( privilege != chain::privilege::kernel_mode )
    {
 #ifdef BUILD_FOR_TESTING
-      if ( !system::check_authority( constants::contract_id ) )
+      if ( !system::check_authority( context::contract_id() ) )
          system::fail( "can only mint token with contract authority", chain::error_code::authorization_failure );
 #else
       system::fail( "can only mint token from kernel context", chain::error_code::authorization_failure );
 #endif
    }
 
-   auto supply = total_supply().get_value();
-   auto new_supply = supply + amount;
-
-   // Check overflow
-   if ( new_supply < supply )
+   // Check overflow against the exact total
+   auto counters = state::get_supply_counters();
+   uint64_t new_supply;
+   if ( __builtin_add_overflow( counters.total(), amount, &new_supply ) )
       system::revert( "mint would overflow supply" );
 
-   koin::mana_balance_object to_bal_obj;
-   system::get_object( state::balance_space(), to, to_bal_obj );
+   // The shard also takes over the legacy supply, if it has not been folded yet
+   auto shard = state::supply_shard( to );
+   int64_t delta;
+   if ( __builtin_add_overflow( counters.deltas[ shard ], amount, &delta )
+     || __builtin_add_overflow( delta, counters.legacy, &delta ) )
+      system::revert( "mint would overflow supply shard" );
+
+   auto to_bal_obj = state::get_balance( to );
 
    regenerate_mana( to_bal_obj );
 
    to_bal_obj.set_balance( to_bal_obj.balance() + amount );
    to_bal_obj.set_mana( to_bal_obj.mana() + amount );
 
-   token::balance_object supply_obj;
-   supply_obj.set_value( new_supply );
-
-   system::put_object( state::supply_space(), constants::supply_key, supply_obj );
-   system::put_object( state::balance_space(), to, to_bal_obj );
+   if ( counters.has_legacy )
+      system::remove_object( state::supply_space(), constants::supply_key );
+   state::put_supply_delta( shard, delta );
+   state::put_balance( to, to_bal_obj );
 
    token::mint_event< constants::max_address_size > mint_event;
    mint_event.mutable_to().set( args.get_to().get_const(), args.get_to().get_length() );
    mint_event.set_value( amount );
 
-   std::vector< std::string > impacted;
-   impacted.push_back( to );
-   koinos::system::event( "koinos.contracts.token.mint_event", mint_event, impacted );
+   koinos::system::event( events::mint, mint_event, { to } );
 
    return token::mint_result();
 }
 
 token::burn_result burn( const token::burn_arguments< constants::max_address_size >& args )
 {
-   std::string from( reinterpret_cast< const char* >( args.get_from().get_const() ), args.get_from().get_length() );
+   auto from = view( args.get_from() );
    uint64_t value = args.get_value();
 
-   const auto [ caller, privilege ] = system::get_caller();
-   if ( caller != from && !system::check_authority( from, arguments ) )
+   const auto& [ caller, privilege ] = context::caller();
+   if ( caller != from && !system::check_authority( std::string( from ), dispatch::arguments() ) )
       system::fail( "from has not authorized burn", chain::error_code::authorization_failure );
 
-   koin::mana_balance_object from_bal_obj;
-   system::get_object( state::balance_space(), from, from_bal_obj );
+   auto from_bal_obj = state::get_balance( from );
 
    if ( from_bal_obj.balance() < value )
       system::fail( "account 'from' has insufficient balance" );
@@ -337,134 +635,128 @@ token::burn_result burn( const token::burn_arguments< constants::max_address_siz
    from_bal_obj.set_balance( from_bal_obj.balance() - value );
    from_bal_obj.set_mana( from_bal_obj.mana() - value );
 
-   auto supply = total_supply().get_value();
-
-   // Check underflow
-   if ( value > supply )
-      system::revert( "burn would underflow supply" );
-
-   auto new_supply = supply - value;
+   // Total supply covers every balance, so only the shard's delta can leave
+   // its range
+   auto shard = state::supply_shard( from );
+   int64_t delta;
+   if ( __builtin_sub_overflow( state::get_supply_delta( shard ), value, &delta ) )
+      system::revert( "burn would underflow supply shard" );
 
-   token::balance_object supply_obj;
-   supply_obj.set_value( new_supply );
-
-   system::put_object( state::supply_space(), constants::supply_key, supply_obj );
-   system::put_object( state::balance_space(), from, from_bal_obj );
+   state::put_supply_delta( shard, delta );
+   state::put_balance( from, from_bal_obj );
 
    token::burn_event< constants::max_address_size > burn_event;
    burn_event.mutable_from().set( args.get_from().get_const(), args.get_from().get_length() );
    burn_event.set_value( args.get_value() );
 
-   std::vector< std::string > impacted;
-   impacted.push_back( from );
-   koinos::system::event( "koinos.contracts.token.burn_event", burn_event, impacted );
+   koinos::system::event( events::burn, burn_event, { from } );
 
    return token::burn_result();
 }
 
-int main()
+template< typename T >
+T decode( const EmbeddedProto::FieldBytes< constants::max_access_args >& bytes )
 {
-   uint32_t entry_point;
-   std::tie( entry_point, arguments ) = system::get_arguments();
+   T args;
+   koinos::read_buffer rdbuf( const_cast< uint8_t* >( bytes.get_const() ), bytes.get_length() );
+   args.deserialize( rdbuf );
+   return args;
+}
 
-   std::array< uint8_t, constants::max_buffer_size > retbuf;
+void declare( get_access_set_result& res, uint32_t space, std::string_view key, bool write = true )
+{
+   access_key k;
+   k.set_space( space );
+   k.mutable_key().set( reinterpret_cast< const uint8_t* >( key.data() ), key.size() );
+   res.add_reads( k );
+   if ( write )
+      res.add_writes( k );
+}
 
-   koinos::read_buffer rdbuf( (uint8_t*)arguments.c_str(), arguments.size() );
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+// The balance and supply keys a successful call of the given entry reads and
+// writes, every key it writes is read first. A failing call touches a subset.
+// Calls that do not write a key the other reads or writes leave the same state
+// in any order. Mint reads every supply shard for its overflow check and writes
+// the legacy supply object while it exists, so the declared set depends on
+// whether the object has been folded into a shard yet.
+get_access_set_result get_access_set( const get_access_set_arguments& args )
+{
+   get_access_set_result res;
+   const auto& call_args = args.get_arguments();
 
-   switch( std::underlying_type_t< entries >( entry_point ) )
+   switch ( args.get_entry_point() )
    {
-      case entries::get_account_rc_entry:
+      case abi::koin::transfer.id:
       {
-         get_account_rc_arguments arg;
-         arg.deserialize( rdbuf );
+         auto transfer_args = decode< token::transfer_arguments< constants::max_address_size, constants::max_address_size > >( call_args );
+         auto from = view( transfer_args.get_from() );
+         auto to = view( transfer_args.get_to() );
 
-         auto res = get_account_rc( arg );
-         res.serialize( buffer );
+         declare( res, constants::balance_id, from );
+         if ( to != from )
+            declare( res, constants::balance_id, to );
          break;
       }
-      case entries::consume_account_rc_entry:
+      case abi::koin::mint.id:
       {
-         consume_account_rc_arguments arg;
-         arg.deserialize( rdbuf );
-
-         auto res = consume_account_rc( arg );
-         res.serialize( buffer );
+         auto mint_args = decode< token::mint_arguments< constants::max_address_size > >( call_args );
+         auto to = view( mint_args.get_to() );
+         auto shard = state::supply_shard( to );
+
+         declare( res, constants::supply_id, constants::supply_key, state::has_legacy_supply() );
+         for ( uint32_t i = 0; i < constants::supply_shards; i++ )
+            declare( res, constants::supply_id, state::supply_shard_key( i ), i == shard );
+         declare( res, constants::balance_id, to );
          break;
       }
-      case entries::name_entry:
+      case abi::koin::burn.id:
       {
-         auto res = name();
-         res.serialize( buffer );
+         auto burn_args = decode< token::burn_arguments< constants::max_address_size > >( call_args );
+         auto from = view( burn_args.get_from() );
+         declare( res, constants::balance_id, from );
+         declare( res, constants::supply_id, state::supply_shard_key( state::supply_shard( from ) ) );
          break;
       }
-      case entries::symbol_entry:
+      case entries::consume_account_rc.id:
       {
-         auto res = symbol();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::decimals_entry:
-      {
-         auto res = decimals();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::total_supply_entry:
-      {
-         auto res = total_supply();
-         res.serialize( buffer );
-         break;
-      }
-      case entries::balance_of_entry:
-      {
-         token::balance_of_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = balance_of( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::transfer_entry:
-      {
-         token::transfer_arguments< constants::max_address_size, constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = transfer( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::mint_entry:
-      {
-         token::mint_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = mint( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::burn_entry:
-      {
-         token::burn_arguments< constants::max_address_size > arg;
-         arg.deserialize( rdbuf );
-
-         auto res = burn( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::authorize_entry:
-      {
-         chain::authorize_result res;
-         res.set_value( system::check_system_authority() );
-         res.serialize( buffer );
+         auto rc_args = decode< consume_account_rc_arguments >( call_args );
+         declare( res, constants::balance_id, view( rc_args.get_account() ) );
          break;
       }
       default:
-         system::revert( "unknown entry point" );
+         system::revert( "entry point has no declared access set" );
    }
 
-   system::result r;
-   r.mutable_object().set( buffer.data(), buffer.get_size() );
+   return res;
+}
 
-   system::exit( 0, r );
+chain::authorize_result authorize()
+{
+   chain::authorize_result res;
+   res.set_value( system::check_system_authority() );
+   return res;
+}
+
+using dispatcher = dispatch::table< constants::max_buffer_size,
+   dispatch::method< entries::get_account_rc, get_account_rc >,
+   dispatch::method< entries::consume_account_rc, consume_account_rc >,
+   dispatch::method< entries::consume_accounts_rc_batch, consume_accounts_rc_batch >,
+   dispatch::method< abi::koin::name, name >,
+   dispatch::method< abi::koin::symbol, symbol >,
+   dispatch::method< abi::koin::decimals, decimals >,
+   dispatch::method< abi::koin::total_supply, total_supply >,
+   dispatch::method< abi::koin::balance_of, balance_of >,
+   dispatch::method< abi::koin::transfer, transfer >,
+   dispatch::method< abi::koin::transfer_batch, transfer_batch >,
+   dispatch::method< abi::koin::mint, mint >,
+   dispatch::method< abi::koin::burn, burn >,
+   dispatch::method< abi::koin::get_access_set, get_access_set >,
+   dispatch::method< dispatch::authorize, authorize >
+>;
+
+static_assert( dispatcher::implements( abi::koin::methods ), "every koin.abi method needs a handler" );
+
+int main()
+{
+   return dispatcher::run();
 }
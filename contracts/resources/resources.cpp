@@ -2,33 +2,32 @@
 #include <koinos/token.hpp>
 
 #include <koinos/chain/authority.h>
+#include <koinos/contracts/context.hpp>
+#include <koinos/contracts/dispatch.hpp>
+#include <koinos/contracts/integer.hpp>
 #include <koinos/contracts/resources/resources.h>
+#include <koinos/contracts/system_calls.hpp>
 
-#include <boost/multiprecision/cpp_int.hpp>
+#include <resources_abi.hpp>
+
+#include <array>
+#include <string_view>
+#include <utility>
 
 using namespace koinos;
+using namespace koinos::contracts;
 using namespace koinos::contracts::resources;
 using namespace std::string_literals;
 
-using uint128_t = boost::multiprecision::uint128_t;
-
-enum entries : uint32_t
-{
-   get_resource_limits_entry             = 0x427a0394,
-   consume_block_resources_entry         = 0x9850b1fd,
-   get_resource_markets_entry            = 0xebe9b9e7,
-   set_resource_markets_parameters_entry = 0x4b31e959,
-   get_resource_parameters_entry         = 0xf53b5216,
-   set_resource_parameters_entry         = 0xa08e6b90,
-   authorize_entry                       = 0x4a2dbd90
-};
-
 namespace constants {
 
 constexpr std::size_t max_buffer_size         = 2048;
 constexpr uint64_t num_resources              = 3;
-const std::string markets_key                 = "markets";
-const std::string parameters_keys             = "parameters";
+constexpr std::string_view state_key          = "state";
+constexpr std::string_view markets_key        = "markets";
+constexpr std::string_view parameters_keys    = "parameters";
+constexpr std::string_view limits_key         = "limits";
+constexpr uint32_t state_version              = 1;
 
 constexpr uint64_t disk_budget_per_block_default    = 39600; // 10G per month
 constexpr uint64_t max_disk_per_block_default       = 1 << 19; // 512k
@@ -39,6 +38,7 @@ constexpr uint64_t max_compute_per_block_default    = 287'500'000; // ~0.5s
 
 constexpr uint64_t block_interval_ms_default        = 3'000; // 3s
 constexpr uint64_t rc_regen_ms_default              = 432'000'000; // 5 days
+constexpr uint64_t rc_refresh_interval_blocks       = 1'200; // 1 hour
 
 // Exponential decay constant for 1 month half life
 // Constant is ( 2 ^ (-1 / num_blocks) ) * 2^64
@@ -58,7 +58,7 @@ namespace detail {
 system::object_space create_contract_space()
 {
    system::object_space obj_space;
-   auto contract_id = system::get_contract_id();
+   const auto& contract_id = context::contract_id();
    obj_space.mutable_zone().set( reinterpret_cast< const uint8_t* >( contract_id.data() ), contract_id.size() );
    obj_space.set_id( 0 );
    obj_space.set_system( true );
@@ -67,9 +67,9 @@ system::object_space create_contract_space()
 
 } // detail
 
-system::object_space contract_space()
+const system::object_space& contract_space()
 {
-   static auto space = detail::create_contract_space();
+   static const auto space = detail::create_contract_space();
    return space;
 }
 
@@ -78,19 +78,76 @@ system::object_space contract_space()
 using get_resource_limits_result        = chain::get_resource_limits_result;
 using consume_block_resources_arguments = chain::consume_block_resources_arguments;
 using consume_block_resources_result    = chain::consume_block_resources_result;
+using resource_limit_data               = std::remove_reference_t< decltype( std::declval< get_resource_limits_result& >().mutable_value() ) >;
 
-uint64_t rc_per_block( const resource_parameters& p )
+enum class resource : uint64_t
 {
-   static uint64_t rc = 0;
+   disk_storage,
+   network_bandwidth,
+   compute_bandwidth
+};
+
+// Everything that differs between resource markets. Each computation loops
+// over this table, so adding a market means adding its fields to the protos,
+// a resource and an entry here at that resource's index.
+struct market_entry
+{
+   resource id;
+   uint64_t budget_per_block_default;
+   uint64_t max_per_block_default;
+   const market& ( *get )( const resource_markets& );
+   market& ( *get_mutable )( resource_markets& );
+   const market_parameters& ( *parameters )( const set_resource_markets_parameters_arguments& );
+   uint64_t ( *consumed )( const consume_block_resources_arguments& );
+   void ( *set_limit )( resource_limit_data&, uint64_t limit, uint64_t cost );
+};
 
-   if ( rc == 0 )
+constexpr std::array< market_entry, constants::num_resources > market_table = {{
    {
-      rc = ( ( uint128_t( koinos::token::koin().total_supply() ) * p.block_interval_ms() ) / ( p.rc_regen_ms() * constants::num_resources ) ).convert_to< uint64_t >();
+      resource::disk_storage,
+      constants::disk_budget_per_block_default,
+      constants::max_disk_per_block_default,
+      []( const resource_markets& m ) -> const market& { return m.disk_storage(); },
+      []( resource_markets& m ) -> market& { return m.mutable_disk_storage(); },
+      []( const set_resource_markets_parameters_arguments& a ) -> const market_parameters& { return a.get_disk_storage(); },
+      []( const consume_block_resources_arguments& a ) -> uint64_t { return a.disk_storage_consumed(); },
+      []( resource_limit_data& l, uint64_t limit, uint64_t cost ) { l.set_disk_storage_limit( limit ); l.set_disk_storage_cost( cost ); }
+   },
+   {
+      resource::network_bandwidth,
+      constants::network_budget_per_block_default,
+      constants::max_network_per_block_default,
+      []( const resource_markets& m ) -> const market& { return m.network_bandwidth(); },
+      []( resource_markets& m ) -> market& { return m.mutable_network_bandwidth(); },
+      []( const set_resource_markets_parameters_arguments& a ) -> const market_parameters& { return a.get_network_bandwidth(); },
+      []( const consume_block_resources_arguments& a ) -> uint64_t { return a.network_bandwidth_consumed(); },
+      []( resource_limit_data& l, uint64_t limit, uint64_t cost ) { l.set_network_bandwidth_limit( limit ); l.set_network_bandwidth_cost( cost ); }
+   },
+   {
+      resource::compute_bandwidth,
+      constants::compute_budget_per_block_default,
+      constants::max_compute_per_block_default,
+      []( const resource_markets& m ) -> const market& { return m.compute_bandwidth(); },
+      []( resource_markets& m ) -> market& { return m.mutable_compute_bandwidth(); },
+      []( const set_resource_markets_parameters_arguments& a ) -> const market_parameters& { return a.get_compute_bandwidth(); },
+      []( const consume_block_resources_arguments& a ) -> uint64_t { return a.compute_bandwidth_consumed(); },
+      []( resource_limit_data& l, uint64_t limit, uint64_t cost ) { l.set_compute_bandwidth_limit( limit ); l.set_compute_bandwidth_cost( cost ); }
    }
+}};
 
-   return rc;
+constexpr bool market_table_complete()
+{
+   for ( std::size_t i = 0; i < market_table.size(); i++ )
+   {
+      const auto& entry = market_table[i];
+      if ( std::size_t( entry.id ) != i || !entry.get || !entry.get_mutable || !entry.parameters || !entry.consumed || !entry.set_limit )
+         return false;
+   }
+   return true;
 }
 
+static_assert( market_table_complete(), "every resource needs a complete market_table entry at its own index" );
+
 void initialize_params( resource_parameters& params )
 {
    params.set_block_interval_ms( constants::block_interval_ms_default );
@@ -101,112 +158,207 @@ void initialize_params( resource_parameters& params )
    params.set_print_rate_precision( constants::print_rate_precision_default );
 }
 
-resource_parameters get_resource_parameters()
+uint64_t block_print_rate( const resource_parameters& p, uint64_t block_budget )
 {
-   resource_parameters params;
-   if ( !system::get_object( state::contract_space(), constants::parameters_keys, params ) )
-   {
-      initialize_params( params );
-   }
-
-   return params;
+   return ( block_budget * p.print_rate_premium() ) / p.print_rate_precision();
 }
 
 void initialize_markets( const resource_parameters& p, resource_markets& markets )
 {
-   auto print_rate = ( constants::disk_budget_per_block_default * p.print_rate_premium() ) / p.print_rate_precision();
-   markets.mutable_disk_storage().set_resource_supply( ( ( uint128_t( print_rate ) << 64 ) / p.one_minus_decay_constant() ).convert_to< uint64_t >() );
-   markets.mutable_disk_storage().set_block_budget( constants::disk_budget_per_block_default );
-   markets.mutable_disk_storage().set_block_limit( constants::max_disk_per_block_default );
-
-   print_rate = ( constants::network_budget_per_block_default * p.print_rate_premium() ) / p.print_rate_precision();
-   markets.mutable_network_bandwidth().set_resource_supply( ( ( uint128_t( print_rate ) << 64 ) / p.one_minus_decay_constant() ).convert_to< uint64_t >() );
-   markets.mutable_network_bandwidth().set_block_budget( constants::network_budget_per_block_default );
-   markets.mutable_network_bandwidth().set_block_limit( constants::max_network_per_block_default );
-
-   print_rate = ( constants::compute_budget_per_block_default * p.print_rate_premium() ) / p.print_rate_precision();
-   markets.mutable_compute_bandwidth().set_resource_supply( ( ( uint128_t( print_rate ) << 64 ) / p.one_minus_decay_constant() ).convert_to< uint64_t >() );
-   markets.mutable_compute_bandwidth().set_block_budget( constants::compute_budget_per_block_default );
-   markets.mutable_compute_bandwidth().set_block_limit( constants::max_compute_per_block_default );
+   for ( const auto& entry : market_table )
+   {
+      auto& m = entry.get_mutable( markets );
+      auto print_rate = block_print_rate( p, entry.budget_per_block_default );
+      m.set_resource_supply( uint64_t( ( uint128_t( print_rate ) << 64 ) / p.one_minus_decay_constant() ) );
+      m.set_block_budget( entry.budget_per_block_default );
+      m.set_block_limit( entry.max_per_block_default );
+   }
 }
 
-resource_markets get_resource_markets()
+// Markets, parameters and rc_per_block are kept in one record so each block
+// reads and writes contract state once.
+//
+// Before state_version 1 markets and parameters were separate records. When
+// the record does not exist yet it is assembled from them, and legacy is set
+// if either was found. The caller passes legacy on to put_state, which then
+// removes them.
+resources_state get_state( bool* legacy = nullptr )
 {
-   resource_markets markets;
-   if ( !system::get_object( state::contract_space(), constants::markets_key, markets ) )
+   resources_state s;
+   if ( system::get_object( state::contract_space(), constants::state_key, s ) )
+   {
+      if ( s.version() != constants::state_version )
+      {
+         system::revert( "unsupported resources state version" );
+      }
+
+      return s;
+   }
+
+   s.set_version( constants::state_version );
+   bool found = false;
+
+   if ( system::get_object( state::contract_space(), constants::parameters_keys, s.mutable_params() ) )
+   {
+      found = true;
+   }
+   else
    {
-      initialize_markets( get_resource_parameters(), markets );
+      initialize_params( s.mutable_params() );
    }
 
-   return markets;
+   if ( system::get_object( state::contract_space(), constants::markets_key, s.mutable_markets() ) )
+   {
+      found = true;
+   }
+   else
+   {
+      initialize_markets( s.params(), s.mutable_markets() );
+   }
+
+   if ( legacy )
+   {
+      *legacy = found;
+   }
+
+   return s;
 }
 
-void set_resource_markets( const set_resource_markets_parameters_arguments& params )
+void put_state( const resources_state& s, bool legacy = false )
 {
-   if ( !system::check_system_authority() )
-      system::fail( "can only set market parameters with system authority", chain::error_code::authorization_failure );
+   system::put_object( state::contract_space(), constants::state_key, s );
 
-   auto markets = get_resource_markets();
+   if ( legacy )
+   {
+      system::remove_object( state::contract_space(), constants::parameters_keys );
+      system::remove_object( state::contract_space(), constants::markets_key );
+   }
+}
 
-   markets.mutable_disk_storage().set_block_budget( params.get_disk_storage().get_block_budget() );
-   markets.mutable_disk_storage().set_block_limit( params.get_disk_storage().get_block_limit() );
-   markets.mutable_network_bandwidth().set_block_budget( params.get_network_bandwidth().get_block_budget() );
-   markets.mutable_network_bandwidth().set_block_limit( params.get_network_bandwidth().get_block_limit() );
-   markets.mutable_compute_bandwidth().set_block_budget( params.get_compute_bandwidth().get_block_budget() );
-   markets.mutable_compute_bandwidth().set_block_limit( params.get_compute_bandwidth().get_block_limit() );
+// rc_per_block is derived from the KOIN supply, which is only sampled through
+// a call to the token contract. The sampled value is stored in the state along
+// with the parameters it was derived from. Every write of the state refreshes
+// it once per refresh interval or when the parameters changed, so lookups
+// never make the nested call.
+rc_per_block_object calculate_rc_per_block( const resource_parameters& p )
+{
+   rc_per_block_object rc;
+   rc.set_value( mul_div( koinos::token::koin().total_supply(), p.block_interval_ms(), p.rc_regen_ms() * constants::num_resources ) );
+   rc.set_block_interval_ms( p.block_interval_ms() );
+   rc.set_rc_regen_ms( p.rc_regen_ms() );
+   rc.set_refresh_height( context::head_height() );
+   return rc;
+}
 
-   system::put_object( state::contract_space(), constants::markets_key, markets );
+bool rc_per_block_matches( const rc_per_block_object& rc, const resource_parameters& p )
+{
+   return rc.block_interval_ms() == p.block_interval_ms() && rc.rc_regen_ms() == p.rc_regen_ms();
 }
 
-void set_resource_parameters( const set_resource_parameters_arguments& args )
+uint64_t rc_per_block( const resources_state& s )
 {
-   if ( !system::check_system_authority() )
-      system::fail( "can only set resource parameters with system authority", chain::error_code::authorization_failure );
+   if ( rc_per_block_matches( s.rc_per_block(), s.params() ) )
+   {
+      return s.rc_per_block().value();
+   }
 
-   system::put_object( state::contract_space(), constants::parameters_keys, args.get_params() );
+   return calculate_rc_per_block( s.params() ).value();
+}
+
+// Updates the state's rc_per_block in place, the caller writes the state
+void refresh_rc_per_block( resources_state& s )
+{
+   const auto& rc = s.rc_per_block();
+   if ( !rc_per_block_matches( rc, s.params() )
+      || context::head_height() / constants::rc_refresh_interval_blocks != rc.refresh_height() / constants::rc_refresh_interval_blocks )
+   {
+      s.set_rc_per_block( calculate_rc_per_block( s.params() ) );
+   }
 }
 
-uint128_t calculate_k( const resource_parameters& p, const market& m )
+uint128_t calculate_k( const resource_parameters& p, const market& m, uint64_t rc_per_block, uint64_t print_rate )
 {
-   auto block_print_rate = ( p.print_rate_premium() * m.block_budget() ) / p.print_rate_precision();
-   auto max_resources = ( uint128_t( block_print_rate - m.block_budget() ) << 64 ) / p.one_minus_decay_constant();
-   return ( ( rc_per_block( p ) * max_resources ) / m.block_budget() ) * ( max_resources - m.block_budget() );
+   auto max_resources = ( uint128_t( print_rate - m.block_budget() ) << 64 ) / p.one_minus_decay_constant();
+   return ( ( rc_per_block * max_resources ) / m.block_budget() ) * ( max_resources - m.block_budget() );
 }
 
-std::pair< uint64_t, uint64_t > calculate_market_limit( const resource_parameters& p, const market& m )
+std::pair< uint64_t, uint64_t > calculate_market_limit( const resource_parameters& p, const market& m, uint64_t rc_per_block, uint64_t print_rate )
 {
    auto resource_limit = std::min( m.resource_supply() - 1, m.block_limit() );
-   auto k = calculate_k( p, m );
+   auto k = calculate_k( p, m, rc_per_block, print_rate );
    auto new_supply = m.resource_supply() - resource_limit;
    auto consumed_rc = ( ( k + ( new_supply - 1 ) ) / new_supply ) - ( k / m.resource_supply() );
-   auto rc_cost = ( ( consumed_rc + ( resource_limit - 1 ) ) / resource_limit ).convert_to< uint64_t >();
+   auto rc_cost = uint64_t( ( consumed_rc + ( resource_limit - 1 ) ) / resource_limit );
    return std::make_pair( resource_limit, rc_cost );
 }
 
-get_resource_limits_result get_resource_limits( const resource_parameters& p )
+get_resource_limits_result calculate_resource_limits( const resource_parameters& p, const resource_markets& markets, uint64_t rc_per_block )
 {
-   auto markets = get_resource_markets();
-
-   auto [disk_limit,    disk_cost]    = calculate_market_limit( p, markets.disk_storage() );
-   auto [network_limit, network_cost] = calculate_market_limit( p, markets.network_bandwidth() );
-   auto [compute_limit, compute_cost] = calculate_market_limit( p, markets.compute_bandwidth() );
-
    get_resource_limits_result res;
-   res.mutable_value().set_disk_storage_limit( disk_limit );
-   res.mutable_value().set_disk_storage_cost( disk_cost );
-   res.mutable_value().set_network_bandwidth_limit( network_limit );
-   res.mutable_value().set_network_bandwidth_cost( network_cost );
-   res.mutable_value().set_compute_bandwidth_limit( compute_limit );
-   res.mutable_value().set_compute_bandwidth_cost( compute_cost );
+
+   for ( const auto& entry : market_table )
+   {
+      const auto& m = entry.get( markets );
+      auto [ limit, cost ] = calculate_market_limit( p, m, rc_per_block, block_print_rate( p, m.block_budget() ) );
+      entry.set_limit( res.mutable_value(), limit, cost );
+   }
 
    return res;
 }
 
-void update_market( const resource_parameters& p, market& m, uint64_t consumed )
+// Limits only change when markets or parameters are written, so they are
+// materialized at those points and get_resource_limits becomes a single read
+void put_resource_limits( const get_resource_limits_result& limits )
+{
+   system::put_object( state::contract_space(), constants::limits_key, limits );
+}
+
+// Takes a state that went through refresh_rc_per_block, so the limits use the
+// rc_per_block written with it rather than sampling the supply again
+void update_resource_limits( const resources_state& s )
+{
+   put_resource_limits( calculate_resource_limits( s.params(), s.markets(), s.rc_per_block().value() ) );
+}
+
+void set_resource_markets( const set_resource_markets_parameters_arguments& params )
+{
+   if ( !system::check_system_authority() )
+      system::fail( "can only set market parameters with system authority", chain::error_code::authorization_failure );
+
+   bool legacy = false;
+   auto s = get_state( &legacy );
+
+   for ( const auto& entry : market_table )
+   {
+      auto& m = entry.get_mutable( s.mutable_markets() );
+      m.set_block_budget( entry.parameters( params ).get_block_budget() );
+      m.set_block_limit( entry.parameters( params ).get_block_limit() );
+   }
+
+   refresh_rc_per_block( s );
+
+   put_state( s, legacy );
+   update_resource_limits( s );
+}
+
+void set_resource_parameters( const set_resource_parameters_arguments& args )
+{
+   if ( !system::check_system_authority() )
+      system::fail( "can only set resource parameters with system authority", chain::error_code::authorization_failure );
+
+   bool legacy = false;
+   auto s = get_state( &legacy );
+   s.set_params( args.get_params() );
+   refresh_rc_per_block( s );
+
+   put_state( s, legacy );
+   update_resource_limits( s );
+}
+
+void update_market( const resource_parameters& p, market& m, uint64_t consumed, uint64_t print_rate )
 {
-   auto print_rate = ( m.block_budget() * p.print_rate_premium() ) / p.print_rate_precision();
    auto resource_supply = ( uint128_t( m.resource_supply() ) * p.decay_constant() ) >> 64;
-   m.set_resource_supply( resource_supply.convert_to< uint64_t >() + print_rate - consumed );
+   m.set_resource_supply( uint64_t( resource_supply ) + print_rate - consumed );
 }
 
 consume_block_resources_result consume_block_resources( const consume_block_resources_arguments& args )
@@ -214,107 +366,98 @@ consume_block_resources_result consume_block_resources( const consume_block_reso
    consume_block_resources_result res;
    res.set_value( false );
 
-   const auto [ caller, privilege ] = system::get_caller();
+   const auto& [ caller, privilege ] = context::caller();
    if ( privilege != chain::privilege::kernel_mode )
    {
       system::log( "The system call consume_block_resources must be called from kernel context" );
       return res;
    }
 
-   auto markets = get_resource_markets();
-   auto params = get_resource_parameters();
+   bool legacy = false;
+   auto s = get_state( &legacy );
+   const auto& params = s.params();
+   auto& markets = s.mutable_markets();
 
-   if (  markets.disk_storage().resource_supply()      <= args.disk_storage_consumed()
-      || markets.network_bandwidth().resource_supply() <= args.network_bandwidth_consumed()
-      || markets.compute_bandwidth().resource_supply() <= args.compute_bandwidth_consumed()
-      || markets.disk_storage().block_limit()      <= args.disk_storage_consumed()
-      || markets.network_bandwidth().block_limit() <= args.network_bandwidth_consumed()
-      || markets.compute_bandwidth().block_limit() <= args.compute_bandwidth_consumed() )
+   for ( const auto& entry : market_table )
    {
-      return res;
+      const auto& m = entry.get( markets );
+      auto consumed = entry.consumed( args );
+      if ( m.resource_supply() <= consumed || m.block_limit() <= consumed )
+         return res;
    }
 
-   update_market( params, markets.mutable_disk_storage(),      args.disk_storage_consumed() );
-   update_market( params, markets.mutable_network_bandwidth(), args.network_bandwidth_consumed() );
-   update_market( params, markets.mutable_compute_bandwidth(), args.compute_bandwidth_consumed() );
+   refresh_rc_per_block( s );
+   auto rc = rc_per_block( s );
+
+   // Supply updates and the next block's limits in one pass, sharing each
+   // market's print rate
+   get_resource_limits_result limits;
+
+   for ( const auto& entry : market_table )
+   {
+      auto& m = entry.get_mutable( markets );
+      auto print_rate = block_print_rate( params, m.block_budget() );
+      update_market( params, m, entry.consumed( args ), print_rate );
+
+      auto [ limit, cost ] = calculate_market_limit( params, m, rc, print_rate );
+      entry.set_limit( limits.mutable_value(), limit, cost );
+   }
 
-   system::put_object( state::contract_space(), constants::markets_key, markets );
+   put_state( s, legacy );
+   put_resource_limits( limits );
 
    res.set_value( true );
    return res;
 }
 
-int main()
+void get_resource_limits( koinos::write_buffer& buffer )
 {
-   auto [entry_point, args] = system::get_arguments();
-
-   std::array< uint8_t, constants::max_buffer_size > retbuf;
-
-   koinos::read_buffer rdbuf( (uint8_t*)args.c_str(), args.size() );
-   koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
-
-   switch( std::underlying_type_t< entries >( entry_point ) )
+   // Stored limits are already a serialized result and are returned as is
+   if ( auto limits = system::detail::get_object( state::contract_space(), constants::limits_key ); limits.size() )
    {
-      case entries::get_resource_limits_entry:
-      {
-         auto res = get_resource_limits( get_resource_parameters() );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::consume_block_resources_entry:
-      {
-         consume_block_resources_arguments arg;
-         arg.deserialize( rdbuf );
+      buffer.push( reinterpret_cast< const uint8_t* >( limits.data() ), limits.size() );
+   }
+   else
+   {
+      auto s = get_state();
+      calculate_resource_limits( s.params(), s.markets(), rc_per_block( s ) ).serialize( buffer );
+   }
+}
 
-         auto res = consume_block_resources( arg );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::get_resource_markets_entry:
-      {
-         get_resource_markets_result res;
-         res.set_value( get_resource_markets() );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::set_resource_markets_parameters_entry:
-      {
-         set_resource_markets_parameters_arguments arg;
-         arg.deserialize( rdbuf );
+get_resource_markets_result get_resource_markets()
+{
+   get_resource_markets_result res;
+   res.set_value( get_state().markets() );
+   return res;
+}
 
-         set_resource_markets( arg );
-         break;
-      }
-      case entries::get_resource_parameters_entry:
-      {
-         get_resource_parameters_result res;
-         res.set_value( get_resource_parameters() );
-         res.serialize( buffer );
-         break;
-      }
-      case entries::set_resource_parameters_entry:
-      {
-         set_resource_parameters_arguments arg;
-         arg.deserialize( rdbuf );
+get_resource_parameters_result get_resource_parameters()
+{
+   get_resource_parameters_result res;
+   res.set_value( get_state().params() );
+   return res;
+}
 
-         set_resource_parameters( arg );
-         break;
-      }
-      case entries::authorize_entry:
-      {
-         chain::authorize_result res;
-         res.set_value( system::check_system_authority() );
-         res.serialize( buffer );
-         break;
-      }
-      default:
-         return 1;
-   }
+chain::authorize_result authorize()
+{
+   chain::authorize_result res;
+   res.set_value( system::check_system_authority() );
+   return res;
+}
 
-   system::result r;
-   r.mutable_object().set( buffer.data(), buffer.get_size() );
+using dispatcher = dispatch::table< constants::max_buffer_size,
+   dispatch::method< abi::resources::get_resource_limits, get_resource_limits >,
+   dispatch::method< abi::resources::consume_block_resources, consume_block_resources >,
+   dispatch::method< abi::resources::get_resource_markets, get_resource_markets >,
+   dispatch::method< abi::resources::set_resource_markets_parameters, set_resource_markets >,
+   dispatch::method< abi::resources::get_resource_parameters, get_resource_parameters >,
+   dispatch::method< abi::resources::set_resource_parameters, set_resource_parameters >,
+   dispatch::method< dispatch::authorize, authorize >
+>;
 
-   system::exit( 0, r );
+static_assert( dispatcher::implements( abi::resources::methods ), "every resources.abi method needs a handler" );
 
-   return 0;
+int main()
+{
+   return dispatcher::run();
 }
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace koinos::mock::crypto {
+
+std::array< uint8_t, 32 > sha256( const void* data, std::size_t size );
+std::array< uint8_t, 20 > ripemd160( const void* data, std::size_t size );
+
+} // koinos::mock::crypto
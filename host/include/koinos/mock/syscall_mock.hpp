@@ -0,0 +1,99 @@
+#pragma once
+
+// In-process harness around the host system call mock.
+//
+// Contracts built with BUILD_FOR_HOST are loadable modules. The harness loads
+// them under a contract id, owns the object store they read and write, and
+// drives their main() through invoke().
+//
+// Every thread has its own mock: loaded contracts, objects, caller, counters
+// and everything else set here apply to the calling thread only. A module's
+// static state is shared by every thread that loads the same file, so threads
+// running a contract at the same time each load their own copy of its module.
+
+#include <koinos/system/system_calls.hpp>
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace koinos::mock {
+
+// Thrown by system::exit to unwind back to the invoking frame
+struct exit_exception
+{
+   int32_t     code;
+   std::string value;
+};
+
+struct event_record
+{
+   std::string                source;
+   std::string                name;
+   std::string                data;
+   std::vector< std::string > impacted;
+};
+
+// Totals over all invocations since the last reset_counters()
+struct counters
+{
+   uint64_t system_calls     = 0;
+   uint64_t objects_read     = 0;
+   uint64_t objects_written  = 0;
+   uint64_t bytes_serialized = 0; // Objects written, event data and results
+};
+
+// Store keys of the objects read and written while tracking is enabled,
+// including those of invocations that were later reverted
+struct access_set
+{
+   std::set< std::string > reads;
+   std::set< std::string > writes;
+};
+
+// Calls made by other contracts into a system contract run in kernel mode
+void load_contract( const std::string& contract_id, const std::string& path, bool system_contract = false );
+std::pair< int32_t, std::string > invoke( const std::string& contract_id, uint32_t entry_point, const std::string& args );
+
+// Unique per invocation; host modules stay loaded so per-execution caches key off this
+uint64_t invocation_id();
+
+void set_head_block_time( uint64_t time );
+void set_head_height( uint64_t height );
+void set_caller( const std::string& caller, chain::privilege privilege );
+void set_authority( const std::string& account, bool authorized );
+void set_system_authority( bool authorized );
+void set_public_key( const std::string& signature, const std::string& digest, const std::string& public_key );
+
+// Writes an object directly, outside of any invocation, to seed state
+void set_object( const system::object_space& space, const std::string& key, const std::string& value );
+
+// Key of an object in the store, as listed by objects() and accesses()
+std::string store_key( const system::object_space& space, std::string_view key );
+
+// Write or remove an object by its store key, as listed by objects()
+void set_object( const std::string& store_key, const std::string& value );
+void remove_object( const std::string& store_key );
+
+void reset_state();
+const std::unordered_map< std::string, std::string >& objects();
+const std::vector< event_record >& events();
+const std::vector< std::string >& logs();
+void clear_events();
+
+void track_accesses( bool enabled );
+const access_set& accesses();
+void clear_accesses();
+
+const counters& get_counters();
+void reset_counters();
+
+// True while the mock updates its own object store, journal, events or call
+// frames, so a harness can tell those allocations apart from a contract's
+bool in_host();
+
+} // koinos::mock
@@ -0,0 +1,110 @@
+#pragma once
+
+// Host replacement for the CDT's koinos/system/system_calls.hpp.
+//
+// Declares the subset of the system call API used by the system contracts.
+// Every call is serviced in-process by koinos_syscall_mock instead of being
+// forwarded to the VM through invoke_system_call.
+
+#include <koinos/buffer.hpp>
+
+#include <koinos/chain/chain.h>
+#include <koinos/chain/error.h>
+#include <koinos/chain/system_call_ids.h>
+
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+extern "C" void invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written );
+
+namespace koinos::system {
+
+namespace detail {
+
+constexpr std::size_t max_hash_size       = 67;
+constexpr std::size_t max_address_size    = 25;
+constexpr std::size_t max_proposal_length = 8;
+constexpr std::size_t max_argument_size   = 2048;
+constexpr std::size_t max_buffer_size     = 8192;
+
+extern thread_local std::array< uint8_t, max_buffer_size > syscall_buffer;
+
+} // detail
+
+using object_space = chain::object_space< detail::max_hash_size >;
+using head_info    = chain::head_info< detail::max_hash_size, detail::max_hash_size, detail::max_hash_size >;
+using result       = chain::result< detail::max_argument_size, detail::max_argument_size >;
+
+namespace detail {
+
+std::string get_object( const object_space& space, std::string_view key );
+std::string get_object( const object_space& space, uint64_t key );
+void put_object( const object_space& space, std::string_view key, std::string_view obj );
+void put_object( const object_space& space, uint64_t key, std::string_view obj );
+void remove_object( const object_space& space, std::string_view key );
+void event( std::string_view name, std::string_view data, const std::vector< std::string >& impacted );
+void event( std::string_view name, std::string_view data, std::initializer_list< std::string_view > impacted );
+std::string_view hash( uint64_t code, std::string_view obj, uint64_t size );
+
+} // detail
+
+std::pair< uint32_t, std::string > get_arguments();
+std::string get_contract_id();
+head_info get_head_info();
+std::pair< std::string, chain::privilege > get_caller();
+bool check_authority( const std::string& account, const std::string& data = "" );
+bool check_system_authority();
+std::string hash( uint64_t code, const std::string& obj, uint64_t size = 0 );
+std::string recover_public_key( const std::string& signature, const std::string& digest );
+std::pair< int32_t, std::string > call( const std::string& contract_id, uint32_t entry_point, const std::string& args );
+void log( const std::string& msg );
+
+[[noreturn]] void exit( int32_t code, const result& res = result() );
+[[noreturn]] void revert( const std::string& msg = "" );
+[[noreturn]] void fail( const std::string& msg, chain::error_code code = chain::error_code::failure );
+
+template< typename T >
+[[noreturn]] void exit( const T& t )
+{
+   koinos::write_buffer buffer( detail::syscall_buffer.data(), detail::syscall_buffer.size() );
+   t.serialize( buffer );
+
+   result res;
+   res.mutable_object().set( buffer.data(), buffer.get_size() );
+   exit( 0, res );
+}
+
+template< typename T >
+bool get_object( const object_space& space, const std::string& key, T& t )
+{
+   auto obj = detail::get_object( space, key );
+   if ( !obj.size() )
+      return false;
+
+   koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( obj.data() ), obj.size() );
+   t.deserialize( rdbuf );
+   return true;
+}
+
+template< typename T >
+void put_object( const object_space& space, const std::string& key, const T& t )
+{
+   koinos::write_buffer buffer( detail::syscall_buffer.data(), detail::syscall_buffer.size() );
+   t.serialize( buffer );
+   detail::put_object( space, key, std::string_view( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() ) );
+}
+
+template< typename T >
+void event( const std::string& name, const T& data, const std::vector< std::string >& impacted = {} )
+{
+   koinos::write_buffer buffer( detail::syscall_buffer.data(), detail::syscall_buffer.size() );
+   data.serialize( buffer );
+   detail::event( name, std::string_view( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() ), impacted );
+}
+
+} // koinos::system
@@ -0,0 +1,676 @@
+#include <koinos/system/system_calls.hpp>
+#include <koinos/mock/crypto.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <dlfcn.h>
+
+#include <cstring>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+
+namespace koinos::system::detail {
+
+thread_local std::array< uint8_t, max_buffer_size > syscall_buffer;
+
+} // koinos::system::detail
+
+namespace koinos::mock {
+
+namespace {
+
+constexpr uint64_t sha256_id    = 0x12;
+constexpr uint64_t ripemd160_id = 0x1053;
+
+struct frame
+{
+   std::string      contract_id;
+   uint32_t         entry_point = 0;
+   std::string      arguments;
+   std::string      caller;
+   chain::privilege privilege = chain::privilege::kernel_mode;
+   uint64_t         invocation_id = 0;
+};
+
+struct contract_module
+{
+   void* handle = nullptr;
+   int ( *entry )() = nullptr;
+   bool  system = false;
+};
+
+struct host_context
+{
+   std::unordered_map< std::string, std::string >                         objects;
+   std::vector< std::pair< std::string, std::optional< std::string > > > journal;
+   std::vector< frame >                                                   frames;
+   std::unordered_map< std::string, contract_module >                     contracts;
+   std::vector< event_record >                                            events;
+   std::vector< std::string >                                             logs;
+   std::set< std::string >                                                authorized;
+   std::map< std::pair< std::string, std::string >, std::string >         public_keys;
+   std::string                                                            caller;
+   chain::privilege                                                       privilege = chain::privilege::kernel_mode;
+   bool                                                                   system_authority = false;
+   uint64_t                                                               head_block_time = 0;
+   uint64_t                                                               head_height = 0;
+   uint64_t                                                               invocations = 0;
+   mock::counters                                                         counters;
+   mock::access_set                                                       accesses;
+   bool                                                                   tracking = false;
+   uint32_t                                                               host_depth = 0;
+};
+
+// Per thread, so threads each drive their own modules against their own state
+host_context& context()
+{
+   static thread_local host_context ctx;
+   return ctx;
+}
+
+const frame& current_frame()
+{
+   auto& ctx = context();
+   if ( ctx.frames.empty() )
+      throw std::logic_error( "system call made outside of a contract invocation" );
+
+   return ctx.frames.back();
+}
+
+struct system_call_scope
+{
+   system_call_scope()
+   {
+      context().counters.system_calls++;
+   }
+};
+
+// Marks work on the mock's own bookkeeping for in_host()
+struct host_scope
+{
+   host_scope()
+   {
+      context().host_depth++;
+   }
+
+   ~host_scope()
+   {
+      context().host_depth--;
+   }
+};
+
+std::string object_key( const system::object_space& space, std::string_view key )
+{
+   const auto& zone = space.get_zone();
+   uint32_t id = space.get_id();
+
+   std::string k;
+   k.reserve( 1 + zone.get_length() + sizeof( id ) + 1 + key.size() );
+   k.push_back( char( zone.get_length() ) );
+   k.append( reinterpret_cast< const char* >( zone.get_const() ), zone.get_length() );
+   k.append( reinterpret_cast< const char* >( &id ), sizeof( id ) );
+   k.push_back( space.get_system() ? 1 : 0 );
+   k.append( key );
+   return k;
+}
+
+std::string integer_key( uint64_t key )
+{
+   std::string k( sizeof( key ), '\0' );
+   for ( std::size_t i = 0; i < sizeof( key ); i++ )
+      k[i] = char( key >> ( ( sizeof( key ) - 1 - i ) * 8 ) );
+   return k;
+}
+
+void append_varint( std::string& s, uint64_t v )
+{
+   while ( v >= 0x80 )
+   {
+      s.push_back( char( ( v & 0x7f ) | 0x80 ) );
+      v >>= 7;
+   }
+   s.push_back( char( v ) );
+}
+
+template< std::size_t N >
+std::string multihash( uint64_t code, const std::array< uint8_t, N >& digest )
+{
+   std::string mh;
+   append_varint( mh, code );
+   append_varint( mh, N );
+   mh.append( reinterpret_cast< const char* >( digest.data() ), N );
+   return mh;
+}
+
+std::string hash_object( uint64_t code, std::string_view obj )
+{
+   switch ( code )
+   {
+      case sha256_id:
+         return multihash( code, crypto::sha256( obj.data(), obj.size() ) );
+      case ripemd160_id:
+         return multihash( code, crypto::ripemd160( obj.data(), obj.size() ) );
+      default:
+         system::fail( "hash code is not supported by the host mock" );
+   }
+}
+
+std::string read_object( const system::object_space& space, std::string_view key )
+{
+   auto& ctx = context();
+   ctx.counters.objects_read++;
+
+   const std::string* obj = nullptr;
+   {
+      host_scope host;
+      auto k = object_key( space, key );
+      if ( auto itr = ctx.objects.find( k ); itr != ctx.objects.end() )
+         obj = &itr->second;
+      if ( ctx.tracking )
+         ctx.accesses.reads.insert( std::move( k ) );
+   }
+
+   return obj ? *obj : std::string();
+}
+
+void write_object( const system::object_space& space, std::string_view key, std::string_view obj )
+{
+   auto& ctx = context();
+   ctx.counters.objects_written++;
+   ctx.counters.bytes_serialized += obj.size();
+
+   host_scope host;
+   auto k = object_key( space, key );
+
+   if ( ctx.tracking )
+      ctx.accesses.writes.insert( k );
+
+   if ( auto itr = ctx.objects.find( k ); itr != ctx.objects.end() )
+   {
+      ctx.journal.emplace_back( k, std::move( itr->second ) );
+      itr->second = obj;
+   }
+   else
+   {
+      ctx.journal.emplace_back( k, std::nullopt );
+      ctx.objects.emplace( std::move( k ), obj );
+   }
+}
+
+void erase_object( const system::object_space& space, std::string_view key )
+{
+   auto& ctx = context();
+   ctx.counters.objects_written++;
+
+   host_scope host;
+   auto k = object_key( space, key );
+
+   if ( ctx.tracking )
+      ctx.accesses.writes.insert( k );
+
+   if ( auto itr = ctx.objects.find( k ); itr != ctx.objects.end() )
+   {
+      ctx.journal.emplace_back( k, std::move( itr->second ) );
+      ctx.objects.erase( itr );
+   }
+}
+
+void record_event( std::string_view name, std::string_view data, std::vector< std::string > impacted )
+{
+   auto& ctx = context();
+   ctx.counters.bytes_serialized += data.size();
+
+   host_scope host;
+   ctx.events.push_back( event_record{ current_frame().contract_id, std::string( name ), std::string( data ), std::move( impacted ) } );
+}
+
+void rollback( std::size_t checkpoint )
+{
+   auto& ctx = context();
+   while ( ctx.journal.size() > checkpoint )
+   {
+      auto& [ key, value ] = ctx.journal.back();
+      if ( value )
+         ctx.objects[ key ] = std::move( *value );
+      else
+         ctx.objects.erase( key );
+      ctx.journal.pop_back();
+   }
+}
+
+// Restores the host depth, and once the invocation's frame is pushed pops it,
+// however the invocation ends. Writes and events are rolled back unless the
+// invocation exits with code 0, including when an exception other than an
+// exit escapes the contract.
+class invocation_scope
+{
+public:
+   invocation_scope() :
+      _ctx( context() ),
+      _depth( _ctx.host_depth )
+   {
+      _ctx.host_depth = _depth + 1;
+   }
+
+   ~invocation_scope()
+   {
+      _ctx.host_depth = _depth + 1;
+
+      if ( _pushed )
+      {
+         _ctx.frames.pop_back();
+
+         if ( !_committed )
+         {
+            rollback( _checkpoint );
+            _ctx.events.resize( _event_count );
+         }
+
+         if ( _ctx.frames.empty() )
+            _ctx.journal.clear();
+      }
+
+      _ctx.host_depth = _depth;
+   }
+
+   invocation_scope( const invocation_scope& ) = delete;
+   invocation_scope& operator=( const invocation_scope& ) = delete;
+
+   void push( frame f )
+   {
+      _checkpoint  = _ctx.journal.size();
+      _event_count = _ctx.events.size();
+      _ctx.frames.push_back( std::move( f ) );
+      _pushed = true;
+   }
+
+   // The contract runs outside of the host bookkeeping
+   void enter_contract() { _ctx.host_depth = 0; }
+   void leave_contract() { _ctx.host_depth = _depth + 1; }
+
+   void commit() { _committed = true; }
+
+private:
+   host_context& _ctx;
+   uint32_t      _depth;
+   std::size_t   _checkpoint  = 0;
+   std::size_t   _event_count = 0;
+   bool          _pushed      = false;
+   bool          _committed   = false;
+};
+
+} // anonymous
+
+void load_contract( const std::string& contract_id, const std::string& path, bool system_contract )
+{
+   auto& ctx = context();
+
+   // Static initializers may already make system calls (e.g. get_contract_id),
+   // they run in a frame of their own and outside of the host bookkeeping
+   {
+      host_scope host;
+      frame f;
+      f.contract_id   = contract_id;
+      f.invocation_id = ++ctx.invocations;
+      ctx.frames.push_back( std::move( f ) );
+   }
+
+   void* handle = dlopen( path.c_str(), RTLD_NOW | RTLD_LOCAL );
+
+   host_scope host;
+   ctx.frames.pop_back();
+
+   if ( !handle )
+      throw std::runtime_error( std::string( "could not load contract: " ) + dlerror() );
+
+   auto entry = reinterpret_cast< int(*)() >( dlsym( handle, "main" ) );
+   if ( !entry )
+      throw std::runtime_error( "contract module does not export main: " + path );
+
+   ctx.contracts[ contract_id ] = contract_module{ handle, entry, system_contract };
+}
+
+std::pair< int32_t, std::string > invoke( const std::string& contract_id, uint32_t entry_point, const std::string& args )
+{
+   auto& ctx = context();
+
+   // Frames and journal are bookkeeping, only the contract itself runs outside of it
+   invocation_scope scope;
+
+   auto itr = ctx.contracts.find( contract_id );
+   if ( itr == ctx.contracts.end() )
+      throw std::runtime_error( "contract has not been loaded" );
+
+   frame f;
+   f.contract_id   = contract_id;
+   f.entry_point   = entry_point;
+   f.arguments     = args;
+   f.invocation_id = ++ctx.invocations;
+
+   if ( ctx.frames.empty() )
+   {
+      f.caller    = ctx.caller;
+      f.privilege = ctx.privilege;
+   }
+   else
+   {
+      f.caller    = ctx.frames.back().contract_id;
+      f.privilege = itr->second.system ? chain::privilege::kernel_mode : chain::privilege::user_mode;
+   }
+
+   scope.push( std::move( f ) );
+
+   int32_t code = 0;
+   std::string value;
+
+   scope.enter_contract();
+   try
+   {
+      code = itr->second.entry();
+   }
+   catch ( const exit_exception& e )
+   {
+      code  = e.code;
+      value = e.value;
+   }
+   scope.leave_contract();
+
+   if ( code == 0 )
+      scope.commit();
+
+   return std::make_pair( code, std::move( value ) );
+}
+
+uint64_t invocation_id()
+{
+   return current_frame().invocation_id;
+}
+
+void set_head_block_time( uint64_t time )
+{
+   context().head_block_time = time;
+}
+
+void set_head_height( uint64_t height )
+{
+   context().head_height = height;
+}
+
+void set_caller( const std::string& caller, chain::privilege privilege )
+{
+   context().caller    = caller;
+   context().privilege = privilege;
+}
+
+void set_authority( const std::string& account, bool authorized )
+{
+   if ( authorized )
+      context().authorized.insert( account );
+   else
+      context().authorized.erase( account );
+}
+
+void set_system_authority( bool authorized )
+{
+   context().system_authority = authorized;
+}
+
+void set_public_key( const std::string& signature, const std::string& digest, const std::string& public_key )
+{
+   context().public_keys[ std::make_pair( signature, digest ) ] = public_key;
+}
+
+void set_object( const system::object_space& space, const std::string& key, const std::string& value )
+{
+   context().objects[ object_key( space, key ) ] = value;
+}
+
+std::string store_key( const system::object_space& space, std::string_view key )
+{
+   return object_key( space, key );
+}
+
+void set_object( const std::string& store_key, const std::string& value )
+{
+   context().objects[ store_key ] = value;
+}
+
+void remove_object( const std::string& store_key )
+{
+   context().objects.erase( store_key );
+}
+
+void reset_state()
+{
+   auto& ctx = context();
+   ctx.objects.clear();
+   ctx.journal.clear();
+   ctx.events.clear();
+   ctx.logs.clear();
+}
+
+const std::unordered_map< std::string, std::string >& objects()
+{
+   return context().objects;
+}
+
+const std::vector< event_record >& events()
+{
+   return context().events;
+}
+
+const std::vector< std::string >& logs()
+{
+   return context().logs;
+}
+
+void clear_events()
+{
+   context().events.clear();
+   context().logs.clear();
+}
+
+void track_accesses( bool enabled )
+{
+   context().tracking = enabled;
+}
+
+const access_set& accesses()
+{
+   return context().accesses;
+}
+
+void clear_accesses()
+{
+   context().accesses = access_set();
+}
+
+const counters& get_counters()
+{
+   return context().counters;
+}
+
+void reset_counters()
+{
+   context().counters = counters();
+}
+
+bool in_host()
+{
+   return context().host_depth > 0;
+}
+
+} // koinos::mock
+
+using namespace koinos;
+
+extern "C" void invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written )
+{
+   mock::system_call_scope scope;
+
+   if ( sid != std::underlying_type_t< chain::system_call_id >( chain::system_call_id::nop ) )
+      system::fail( "raw system call is not supported by the host mock" );
+
+   *bytes_written = 0;
+}
+
+namespace koinos::system {
+
+namespace detail {
+
+std::string get_object( const object_space& space, std::string_view key )
+{
+   mock::system_call_scope scope;
+   return mock::read_object( space, key );
+}
+
+std::string get_object( const object_space& space, uint64_t key )
+{
+   mock::system_call_scope scope;
+   return mock::read_object( space, mock::integer_key( key ) );
+}
+
+void put_object( const object_space& space, std::string_view key, std::string_view obj )
+{
+   mock::system_call_scope scope;
+   mock::write_object( space, key, obj );
+}
+
+void put_object( const object_space& space, uint64_t key, std::string_view obj )
+{
+   mock::system_call_scope scope;
+   mock::write_object( space, mock::integer_key( key ), obj );
+}
+
+void remove_object( const object_space& space, std::string_view key )
+{
+   mock::system_call_scope scope;
+   mock::erase_object( space, key );
+}
+
+void event( std::string_view name, std::string_view data, const std::vector< std::string >& impacted )
+{
+   mock::system_call_scope scope;
+   mock::record_event( name, data, impacted );
+}
+
+void event( std::string_view name, std::string_view data, std::initializer_list< std::string_view > impacted )
+{
+   mock::system_call_scope scope;
+   mock::record_event( name, data, std::vector< std::string >( impacted.begin(), impacted.end() ) );
+}
+
+std::string_view hash( uint64_t code, std::string_view obj, uint64_t size )
+{
+   mock::system_call_scope scope;
+   mock::host_scope host;
+   auto mh = mock::hash_object( code, obj );
+   std::memcpy( syscall_buffer.data(), mh.data(), mh.size() );
+   return std::string_view( reinterpret_cast< const char* >( syscall_buffer.data() ), mh.size() );
+}
+
+} // detail
+
+std::pair< uint32_t, std::string > get_arguments()
+{
+   mock::system_call_scope scope;
+   const auto& f = mock::current_frame();
+   return std::make_pair( f.entry_point, f.arguments );
+}
+
+std::string get_contract_id()
+{
+   mock::system_call_scope scope;
+   return mock::current_frame().contract_id;
+}
+
+head_info get_head_info()
+{
+   mock::system_call_scope scope;
+   head_info info;
+   info.set_head_block_time( mock::context().head_block_time );
+   info.mutable_head_topology().set_height( mock::context().head_height );
+   return info;
+}
+
+std::pair< std::string, chain::privilege > get_caller()
+{
+   mock::system_call_scope scope;
+   const auto& f = mock::current_frame();
+   return std::make_pair( f.caller, f.privilege );
+}
+
+bool check_authority( const std::string& account, const std::string& data )
+{
+   mock::system_call_scope scope;
+   return mock::context().authorized.count( account ) > 0;
+}
+
+bool check_system_authority()
+{
+   mock::system_call_scope scope;
+   return mock::context().system_authority;
+}
+
+std::string hash( uint64_t code, const std::string& obj, uint64_t size )
+{
+   mock::system_call_scope scope;
+   return mock::hash_object( code, obj );
+}
+
+std::string recover_public_key( const std::string& signature, const std::string& digest )
+{
+   mock::system_call_scope scope;
+   const auto& keys = mock::context().public_keys;
+
+   const std::string* key = nullptr;
+   {
+      mock::host_scope host;
+      if ( auto itr = keys.find( std::make_pair( signature, digest ) ); itr != keys.end() )
+         key = &itr->second;
+   }
+
+   if ( key )
+      return *key;
+
+   fail( "signature has no registered public key" );
+}
+
+std::pair< int32_t, std::string > call( const std::string& contract_id, uint32_t entry_point, const std::string& args )
+{
+   mock::system_call_scope scope;
+   return mock::invoke( contract_id, entry_point, args );
+}
+
+void log( const std::string& msg )
+{
+   mock::system_call_scope scope;
+   mock::host_scope host;
+   mock::context().logs.push_back( msg );
+}
+
+void exit( int32_t code, const result& res )
+{
+   mock::system_call_scope scope;
+   mock::host_scope host;
+   const auto& obj = res.get_object();
+   mock::context().counters.bytes_serialized += obj.get_length();
+   throw mock::exit_exception{ code, std::string( reinterpret_cast< const char* >( obj.get_const() ), obj.get_length() ) };
+}
+
+void revert( const std::string& msg )
+{
+   mock::system_call_scope scope;
+   mock::host_scope host;
+   throw mock::exit_exception{ std::underlying_type_t< chain::error_code >( chain::error_code::reversion ), msg };
+}
+
+void fail( const std::string& msg, chain::error_code code )
+{
+   mock::system_call_scope scope;
+   mock::host_scope host;
+   throw mock::exit_exception{ std::underlying_type_t< chain::error_code >( code ), msg };
+}
+
+} // koinos::system
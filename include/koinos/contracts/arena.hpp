@@ -0,0 +1,32 @@
+#pragma once
+
+// Bump allocator for contract heaps in arena builds.
+//
+// With BUILD_WITH_ARENA every contract links src/arena.cpp, which replaces
+// operator new and delete with a bump pointer over a reserved region. Delete
+// is a no-op for arena memory and requests the region cannot hold fall back to
+// the heap. An invocation's allocations all die with it, so the arena is reset
+// when the outermost invocation of the contract exits. In a wasm instance that
+// is when the instance is discarded; host modules stay loaded, and system::exit
+// unwinds through the scope the dispatchers open below.
+
+namespace koinos::contracts::arena {
+
+#ifdef BUILD_WITH_ARENA
+void enter();
+void leave();
+#else
+inline void enter() {}
+inline void leave() {}
+#endif
+
+struct scope
+{
+   scope() { enter(); }
+   ~scope() { leave(); }
+
+   scope( const scope& ) = delete;
+   scope& operator=( const scope& ) = delete;
+};
+
+} // koinos::contracts::arena
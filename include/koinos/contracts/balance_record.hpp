@@ -0,0 +1,94 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// Fixed-width storage layout for KOIN account balances.
+//
+// A record is 24 bytes, little-endian:
+//
+//    [0]       format tag
+//    [1, 8)    last mana update, milliseconds (56 bits)
+//    [8, 16)   balance
+//    [16, 24)  mana
+//
+// Fields are read and written in place, so an access costs a copy of the
+// object bytes rather than a protobuf decode and re-encode. The tag byte is
+// never a valid first byte of a serialized koin::mana_balance_object (wire
+// type 7 is reserved), which lets records written before this layout be told
+// apart. KOIN reads both and writes records, so each account is upgraded when
+// it is next written. Builds with BUILD_WITH_BALANCE_RECORDS off keep writing
+// protobuf.
+//
+// Times that do not fit in 56 bits revert rather than being truncated.
+
+namespace koinos::contracts {
+
+class balance_record
+{
+public:
+   static constexpr std::size_t size       = 24;
+   static constexpr uint8_t     format_tag = 0x07;
+   static constexpr uint64_t    max_time   = ( uint64_t( 1 ) << 56 ) - 1;
+
+   balance_record() { _data[0] = format_tag; }
+
+   // True when the bytes hold a record in this layout
+   static bool is_record( std::string_view bytes )
+   {
+      return bytes.size() == size && uint8_t( bytes[0] ) == format_tag;
+   }
+
+   static balance_record from_bytes( std::string_view bytes )
+   {
+      balance_record r;
+      for ( std::size_t i = 0; i < size; i++ )
+         r._data[i] = uint8_t( bytes[i] );
+      return r;
+   }
+
+   std::string_view bytes() const
+   {
+      return std::string_view( reinterpret_cast< const char* >( _data.data() ), _data.size() );
+   }
+
+   uint64_t last_mana_update() const { return load( 1, 7 ); }
+   uint64_t balance() const          { return load( 8, 8 ); }
+   uint64_t mana() const             { return load( 16, 8 ); }
+
+   uint64_t get_last_mana_update() const { return last_mana_update(); }
+   uint64_t get_balance() const          { return balance(); }
+   uint64_t get_mana() const             { return mana(); }
+
+   void set_balance( uint64_t v ) { store( 8, 8, v ); }
+   void set_mana( uint64_t v )    { store( 16, 8, v ); }
+
+   void set_last_mana_update( uint64_t v )
+   {
+      if ( v > max_time )
+         system::revert( "last mana update out of range" );
+      store( 1, 7, v );
+   }
+
+private:
+   uint64_t load( std::size_t offset, std::size_t width ) const
+   {
+      uint64_t v = 0;
+      for ( std::size_t i = 0; i < width; i++ )
+         v |= uint64_t( _data[offset + i] ) << ( i * 8 );
+      return v;
+   }
+
+   void store( std::size_t offset, std::size_t width, uint64_t v )
+   {
+      for ( std::size_t i = 0; i < width; i++ )
+         _data[offset + i] = uint8_t( v >> ( i * 8 ) );
+   }
+
+   std::array< uint8_t, size > _data = {};
+};
+
+} // koinos::contracts
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#ifdef BUILD_FOR_HOST
+#include <koinos/mock/syscall_mock.hpp>
+#endif
+
+// Invariant values of the current contract execution.
+//
+// Each accessor makes its system call on first use and serves the cached,
+// deserialized value afterwards.
+
+namespace koinos::contracts::context {
+
+namespace detail {
+
+template< typename T >
+class memoized
+{
+public:
+   template< typename Fetch >
+   const T& get( Fetch&& fetch )
+   {
+#ifdef BUILD_FOR_HOST
+      // Host modules stay loaded across invocations, wasm instances do not
+      if ( _invocation != mock::invocation_id() )
+      {
+         _value.reset();
+         _invocation = mock::invocation_id();
+      }
+#endif
+
+      if ( !_value )
+         _value.emplace( fetch() );
+
+      return *_value;
+   }
+
+private:
+   std::optional< T > _value;
+#ifdef BUILD_FOR_HOST
+   uint64_t           _invocation = 0;
+#endif
+};
+
+} // detail
+
+inline const std::string& contract_id()
+{
+   static detail::memoized< std::string > id;
+   return id.get( [] { return system::get_contract_id(); } );
+}
+
+inline const system::head_info& head_info()
+{
+   static detail::memoized< system::head_info > info;
+   return info.get( [] { return system::get_head_info(); } );
+}
+
+inline uint64_t head_block_time()
+{
+   return head_info().get_head_block_time();
+}
+
+inline uint64_t head_height()
+{
+   return head_info().get_head_topology().get_height();
+}
+
+inline const std::pair< std::string, chain::privilege >& caller()
+{
+   static detail::memoized< std::pair< std::string, chain::privilege > > caller_data;
+   return caller_data.get( [] { return system::get_caller(); } );
+}
+
+} // koinos::contracts::context
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <koinos/contracts/arena.hpp>
+#include <koinos/contracts/metrics.hpp>
+
+#include <koinos/buffer.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+// Entry point dispatch for the system contracts.
+//
+// The entries of a contract's .abi file are generated into
+// koinos::contracts::abi::<contract> at build time (see cmake/abi_dispatch.py)
+// and bound to handlers with a table:
+//
+//    using dispatcher = dispatch::table< constants::max_buffer_size,
+//       dispatch::method< abi::koin::transfer, transfer >,
+//       ... >;
+//
+//    static_assert( dispatcher::implements( abi::koin::methods ) );
+//
+//    int main() { return dispatcher::run(); }
+//
+// A handler takes its decoded arguments by const reference, or nothing, and
+// returns its result, or void for an empty result. A handler taking a
+// koinos::write_buffer& serializes its own result. Arguments are decoded into
+// a stack object sized by the handler's argument type.
+//
+// The raw arguments of a method that is not read-only are kept for the
+// duration of the call and are available from dispatch::arguments(), which is
+// what check_authority needs. Read-only methods skip this.
+
+namespace koinos::contracts::dispatch {
+
+struct entry
+{
+   uint32_t id;
+   bool     read_only;
+};
+
+// Called by the chain to check a system contract's own authority, it is not
+// published in the .abi files
+inline constexpr entry authorize = { 0x4a2dbd90, true };
+
+namespace detail {
+
+inline std::string& arguments()
+{
+   static std::string args;
+   return args;
+}
+
+template< typename F >
+struct handler_traits;
+
+template< typename R >
+struct handler_traits< R(*)() >
+{
+   using arguments = void;
+   using result    = R;
+};
+
+template< typename R, typename A >
+struct handler_traits< R(*)( const A& ) >
+{
+   using arguments = A;
+   using result    = R;
+};
+
+template<>
+struct handler_traits< void(*)( koinos::write_buffer& ) >
+{
+   using arguments = void;
+   using result    = koinos::write_buffer;
+};
+
+template< auto Handler >
+void call( const std::string& args, koinos::write_buffer& buffer )
+{
+   using traits = handler_traits< decltype( Handler ) >;
+
+   if constexpr ( std::is_same_v< typename traits::result, koinos::write_buffer > )
+   {
+      Handler( buffer );
+   }
+   else if constexpr ( std::is_void_v< typename traits::arguments > )
+   {
+      if constexpr ( std::is_void_v< typename traits::result > )
+         Handler();
+      else
+         Handler().serialize( buffer );
+   }
+   else
+   {
+      typename traits::arguments arg;
+      koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( const_cast< char* >( args.data() ) ), args.size() );
+      arg.deserialize( rdbuf );
+
+      if constexpr ( std::is_void_v< typename traits::result > )
+         Handler( arg );
+      else
+         Handler( arg ).serialize( buffer );
+   }
+}
+
+} // detail
+
+// Raw arguments of the executing method, empty for read-only methods
+inline const std::string& arguments()
+{
+   return detail::arguments();
+}
+
+template< const entry& Entry, auto Handler >
+struct method
+{
+   static constexpr uint32_t id        = Entry.id;
+   static constexpr bool     read_only = Entry.read_only;
+
+   static void invoke( std::string& args, koinos::write_buffer& buffer )
+   {
+      if constexpr ( read_only )
+      {
+         detail::call< Handler >( args, buffer );
+      }
+      else
+      {
+         detail::arguments() = std::move( args );
+         detail::call< Handler >( detail::arguments(), buffer );
+      }
+   }
+};
+
+template< std::size_t BufferSize, typename... Methods >
+class table
+{
+   static constexpr std::array< uint32_t, sizeof...( Methods ) > ids = { Methods::id... };
+
+   static constexpr bool unique()
+   {
+      for ( std::size_t i = 0; i < ids.size(); i++ )
+         for ( std::size_t j = i + 1; j < ids.size(); j++ )
+            if ( ids[i] == ids[j] )
+               return false;
+      return true;
+   }
+
+   static_assert( unique(), "entry points must be unique" );
+
+public:
+   static constexpr bool contains( uint32_t id )
+   {
+      for ( auto i : ids )
+         if ( i == id )
+            return true;
+      return false;
+   }
+
+   // True when every method of an .abi is bound to a handler
+   template< std::size_t N >
+   static constexpr bool implements( const std::array< entry, N >& abi )
+   {
+      for ( const auto& e : abi )
+         if ( !contains( e.id ) )
+            return false;
+      return true;
+   }
+
+   static int run()
+   {
+      arena::scope arena_scope;
+
+      auto [ entry_point, args ] = system::get_arguments();
+      metrics::begin_entry( entry_point, args.size() );
+
+      std::array< uint8_t, BufferSize > retbuf;
+      koinos::write_buffer buffer( retbuf.data(), retbuf.size() );
+
+      bool found = ( ( entry_point == Methods::id && ( Methods::invoke( args, buffer ), true ) ) || ... );
+      if ( !found )
+         system::revert( "unknown entry point" );
+
+      metrics::end_entry( buffer.get_size() );
+
+      system::result r;
+      r.mutable_object().set( buffer.data(), buffer.get_size() );
+
+      system::exit( 0, r );
+
+      return 0;
+   }
+};
+
+} // koinos::contracts::dispatch
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined( __cpp_exceptions )
+#include <stdexcept>
+#endif
+
+// Fixed-width integer arithmetic for the system contracts.
+//
+// 128-bit values use the compiler's native unsigned __int128, which lowers to
+// a couple of compiler-rt builtins on wasm32. 256-bit values are four 64-bit
+// limbs. Both wrap modulo 2^N like the unchecked boost::multiprecision types
+// they replace, so results are bit-for-bit identical.
+//
+// A zero divisor fails like it did with boost: it throws std::overflow_error,
+// or traps and aborts the contract where exceptions are disabled.
+
+namespace koinos::contracts {
+
+using uint128_t = unsigned __int128;
+
+namespace detail {
+
+[[noreturn]] inline void division_by_zero()
+{
+#if defined( __cpp_exceptions )
+   throw std::overflow_error( "division by zero" );
+#else
+   __builtin_trap();
+#endif
+}
+
+constexpr uint64_t nonzero_divisor( uint64_t d )
+{
+   if ( !d )
+      division_by_zero();
+   return d;
+}
+
+} // detail
+
+// floor( a * b / c ) with a 128-bit intermediate
+constexpr uint64_t mul_div( uint64_t a, uint64_t b, uint64_t c )
+{
+   return uint64_t( ( uint128_t( a ) * b ) / detail::nonzero_divisor( c ) );
+}
+
+// floor( a * b / D ) for a <= D using only 64-bit operations.
+//
+// With b = q * D + r, a * b / D = a * q + a * r / D, and both terms fit in 64
+// bits when a <= D < 2^32. The divisions by D are strength-reduced by the
+// compiler because D is a constant.
+template< uint64_t D >
+constexpr uint64_t mul_div( uint64_t a, uint64_t b )
+{
+   static_assert( D > 0 && D < ( uint64_t( 1 ) << 32 ), "divisor must fit in 32 bits" );
+   return a * ( b / D ) + ( a * ( b % D ) ) / D;
+}
+
+// Division by a 64-bit divisor through its reciprocal, after Moller and
+// Granlund, "Improved division by invariant integers". The divisor is
+// normalized so its top bit is set and a single 128-bit division computes the
+// reciprocal. Every quotient limb then costs one 64 x 64 multiply and at most
+// two corrections instead of a 128 by 64-bit division each.
+class reciprocal_divisor
+{
+public:
+   constexpr explicit reciprocal_divisor( uint64_t d ) :
+      _shift( unsigned( __builtin_clzll( detail::nonzero_divisor( d ) ) ) ),
+      _d( d << _shift ),
+      _v( uint64_t( ( ( uint128_t( ~_d ) << 64 ) | ~uint64_t( 0 ) ) / _d ) )
+   {}
+
+   constexpr unsigned shift() const { return _shift; }
+
+   // Quotient of ( u1 * 2^64 + u0 ) / d for normalized inputs with u1 < d,
+   // the remainder is left in u1
+   constexpr uint64_t divide( uint64_t& u1, uint64_t u0 ) const
+   {
+      uint128_t q = uint128_t( _v ) * u1 + ( ( uint128_t( u1 ) << 64 ) | u0 );
+      uint64_t q1 = uint64_t( q >> 64 ) + 1;
+      uint64_t r  = u0 - q1 * _d;
+
+      // Taken about half the time, so applied as a mask rather than a branch
+      uint64_t mask = -uint64_t( r > uint64_t( q ) );
+      q1 += mask;
+      r  += mask & _d;
+
+      if ( r >= _d )
+      {
+         q1++;
+         r -= _d;
+      }
+
+      u1 = r;
+      return q1;
+   }
+
+private:
+   unsigned _shift;
+   uint64_t _d;
+   uint64_t _v;
+};
+
+class uint256_t
+{
+public:
+   constexpr uint256_t() = default;
+   constexpr uint256_t( uint64_t v ) : _limbs{ v, 0, 0, 0 } {}
+
+   static constexpr uint256_t max()
+   {
+      uint256_t r;
+      for ( auto& l : r._limbs )
+         l = ~uint64_t( 0 );
+      return r;
+   }
+
+   // Big-endian 32 byte encoding
+   static constexpr uint256_t from_big_endian( const uint8_t* in )
+   {
+      uint256_t r;
+      for ( int i = 0; i < 32; i++ )
+         r._limbs[3 - i / 8] |= uint64_t( in[i] ) << ( ( 7 - i % 8 ) * 8 );
+      return r;
+   }
+
+   constexpr void to_big_endian( uint8_t* out ) const
+   {
+      for ( int i = 0; i < 32; i++ )
+         out[i] = uint8_t( _limbs[3 - i / 8] >> ( ( 7 - i % 8 ) * 8 ) );
+   }
+
+   constexpr uint64_t limb( int i ) const { return _limbs[i]; }
+
+   constexpr bool fits_uint64() const { return !( _limbs[1] | _limbs[2] | _limbs[3] ); }
+
+   constexpr uint256_t& operator+=( const uint256_t& o )
+   {
+      uint64_t carry = 0;
+      for ( int i = 0; i < 4; i++ )
+      {
+         uint128_t sum = uint128_t( _limbs[i] ) + o._limbs[i] + carry;
+         _limbs[i] = uint64_t( sum );
+         carry = uint64_t( sum >> 64 );
+      }
+      return *this;
+   }
+
+   constexpr uint256_t& operator-=( const uint256_t& o )
+   {
+      uint64_t borrow = 0;
+      for ( int i = 0; i < 4; i++ )
+      {
+         uint64_t d = _limbs[i] - o._limbs[i];
+         uint64_t b = _limbs[i] < o._limbs[i];
+         _limbs[i] = d - borrow;
+         borrow = b | ( d < borrow );
+      }
+      return *this;
+   }
+
+   constexpr uint256_t& operator*=( uint64_t m )
+   {
+      uint64_t carry = 0;
+      for ( int i = 0; i < 4; i++ )
+      {
+         uint128_t p = uint128_t( _limbs[i] ) * m + carry;
+         _limbs[i] = uint64_t( p );
+         carry = uint64_t( p >> 64 );
+      }
+      return *this;
+   }
+
+   constexpr uint256_t& operator<<=( unsigned s )
+   {
+      if ( s >= 256 )
+         return *this = uint256_t();
+
+      unsigned limbs = s / 64, bits = s % 64;
+      for ( int i = 3; i >= 0; i-- )
+      {
+         uint64_t v = 0;
+         if ( i - int( limbs ) >= 0 )
+         {
+            v = _limbs[i - limbs] << bits;
+            if ( bits && i - int( limbs ) - 1 >= 0 )
+               v |= _limbs[i - limbs - 1] >> ( 64 - bits );
+         }
+         _limbs[i] = v;
+      }
+      return *this;
+   }
+
+   constexpr uint256_t& operator>>=( unsigned s )
+   {
+      if ( s >= 256 )
+         return *this = uint256_t();
+
+      unsigned limbs = s / 64, bits = s % 64;
+      for ( int i = 0; i < 4; i++ )
+      {
+         uint64_t v = 0;
+         if ( i + limbs < 4 )
+         {
+            v = _limbs[i + limbs] >> bits;
+            if ( bits && i + limbs + 1 < 4 )
+               v |= _limbs[i + limbs + 1] << ( 64 - bits );
+         }
+         _limbs[i] = v;
+      }
+      return *this;
+   }
+
+   constexpr uint256_t& operator/=( const uint256_t& d )
+   {
+      return *this = divide( *this, d );
+   }
+
+   friend constexpr uint256_t operator+( uint256_t a, const uint256_t& b ) { return a += b; }
+   friend constexpr uint256_t operator-( uint256_t a, const uint256_t& b ) { return a -= b; }
+   friend constexpr uint256_t operator*( uint256_t a, uint64_t m ) { return a *= m; }
+   friend constexpr uint256_t operator<<( uint256_t a, unsigned s ) { return a <<= s; }
+   friend constexpr uint256_t operator>>( uint256_t a, unsigned s ) { return a >>= s; }
+   friend constexpr uint256_t operator/( const uint256_t& a, const uint256_t& b ) { return divide( a, b ); }
+
+   friend constexpr int compare( const uint256_t& a, const uint256_t& b )
+   {
+      for ( int i = 3; i >= 0; i-- )
+         if ( a._limbs[i] != b._limbs[i] )
+            return a._limbs[i] < b._limbs[i] ? -1 : 1;
+      return 0;
+   }
+
+   friend constexpr bool operator==( const uint256_t& a, const uint256_t& b ) { return compare( a, b ) == 0; }
+   friend constexpr bool operator!=( const uint256_t& a, const uint256_t& b ) { return compare( a, b ) != 0; }
+   friend constexpr bool operator<( const uint256_t& a, const uint256_t& b )  { return compare( a, b ) < 0; }
+   friend constexpr bool operator>( const uint256_t& a, const uint256_t& b )  { return compare( a, b ) > 0; }
+   friend constexpr bool operator<=( const uint256_t& a, const uint256_t& b ) { return compare( a, b ) <= 0; }
+   friend constexpr bool operator>=( const uint256_t& a, const uint256_t& b ) { return compare( a, b ) >= 0; }
+
+private:
+   static constexpr uint256_t divide( const uint256_t& n, const uint256_t& d )
+   {
+      if ( d == uint256_t() )
+         detail::division_by_zero();
+
+      // Single limb divisors, which covers PoW difficulties below 2^64
+      if ( d.fits_uint64() )
+      {
+         reciprocal_divisor div( d._limbs[0] );
+         unsigned s = div.shift();
+
+         // The dividend is shifted with the divisor, its top bits seed the remainder
+         uint256_t q;
+         uint64_t rem = s ? n._limbs[3] >> ( 64 - s ) : 0;
+         for ( int i = 3; i >= 0; i-- )
+         {
+            uint64_t limb = n._limbs[i] << s;
+            if ( s && i > 0 )
+               limb |= n._limbs[i - 1] >> ( 64 - s );
+            q._limbs[i] = div.divide( rem, limb );
+         }
+         return q;
+      }
+
+      // Knuth's algorithm D for divisors of two or more limbs. Both operands
+      // are shifted until the divisor's top bit is set, which keeps each
+      // estimated quotient limb at most two above the true one.
+      unsigned dn = 4;
+      while ( !d._limbs[dn - 1] )
+         dn--;
+
+      unsigned s = unsigned( __builtin_clzll( d._limbs[dn - 1] ) );
+      uint64_t v[4] = { 0, 0, 0, 0 };
+      uint64_t u[5] = { 0, 0, 0, 0, 0 };
+      for ( unsigned i = 0; i < dn; i++ )
+         v[i] = ( d._limbs[i] << s ) | ( s && i ? d._limbs[i - 1] >> ( 64 - s ) : 0 );
+      u[4] = s ? n._limbs[3] >> ( 64 - s ) : 0;
+      for ( unsigned i = 0; i < 4; i++ )
+         u[i] = ( n._limbs[i] << s ) | ( s && i ? n._limbs[i - 1] >> ( 64 - s ) : 0 );
+
+      uint256_t q;
+      for ( int j = int( 4 - dn ); j >= 0; j-- )
+      {
+         uint128_t top  = ( uint128_t( u[j + dn] ) << 64 ) | u[j + dn - 1];
+         uint128_t qhat = top / v[dn - 1];
+         uint128_t rhat = top % v[dn - 1];
+
+         while ( ( qhat >> 64 ) || qhat * v[dn - 2] > ( ( rhat << 64 ) | u[j + dn - 2] ) )
+         {
+            qhat--;
+            rhat += v[dn - 1];
+            if ( rhat >> 64 )
+               break;
+         }
+
+         // Subtract qhat * v from the dividend's window
+         uint64_t mul_carry = 0, borrow = 0;
+         for ( unsigned i = 0; i <= dn; i++ )
+         {
+            uint128_t p = i < dn ? qhat * v[i] + mul_carry : mul_carry;
+            mul_carry = uint64_t( p >> 64 );
+            uint128_t diff = uint128_t( u[i + j] ) - uint64_t( p ) - borrow;
+            u[i + j] = uint64_t( diff );
+            borrow = uint64_t( diff >> 64 ) ? 1 : 0;
+         }
+
+         // The estimate was one too high, add the divisor back
+         if ( borrow )
+         {
+            qhat--;
+            uint64_t carry = 0;
+            for ( unsigned i = 0; i < dn; i++ )
+            {
+               uint128_t sum = uint128_t( u[i + j] ) + v[i] + carry;
+               u[i + j] = uint64_t( sum );
+               carry = uint64_t( sum >> 64 );
+            }
+            u[j + dn] += carry;
+         }
+
+         q._limbs[j] = uint64_t( qhat );
+      }
+      return q;
+   }
+
+   uint64_t _limbs[4] = { 0, 0, 0, 0 };
+};
+
+} // koinos::contracts
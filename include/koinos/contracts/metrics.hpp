@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Per-execution cost counters for metrics builds.
+//
+// With BUILD_WITH_METRICS every system call a contract makes, including those
+// made inside the SDK libraries, is routed through src/metrics.cpp by the
+// linker. It counts calls by id along with object and serialization traffic,
+// and logs the totals when the contract exits. The
+// dispatchers report their entry point and argument and result sizes through
+// the hooks below, which compile to nothing in regular builds.
+
+namespace koinos::contracts::metrics {
+
+#ifdef BUILD_WITH_METRICS
+void begin_entry( uint32_t entry_point, std::size_t argument_bytes );
+void end_entry( std::size_t result_bytes );
+#else
+inline void begin_entry( uint32_t, std::size_t ) {}
+inline void end_entry( std::size_t ) {}
+#endif
+
+} // koinos::contracts::metrics
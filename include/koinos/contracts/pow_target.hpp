@@ -0,0 +1,43 @@
+#pragma once
+
+#include <koinos/contracts/integer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Proof of work verification shared by the PoW contract and the host miner.
+//
+// A block's proof is the SHA-256 of the signature data's nonce followed by the
+// block digest without its multihash prefix. It is accepted when its 32 byte
+// big-endian value does not exceed the current target, max() / difficulty.
+
+namespace koinos::contracts::pow {
+
+constexpr std::size_t hash_size          = 32;
+constexpr std::size_t digest_prefix_size = 2;
+
+// Size of the hash input for the given nonce and multihash digest sizes
+constexpr std::size_t hash_input_size( std::size_t nonce_size, std::size_t digest_size )
+{
+   return nonce_size + digest_size - digest_prefix_size;
+}
+
+// Writes nonce || digest into out, which holds hash_input_size() bytes
+inline void hash_input( uint8_t* out, const uint8_t* nonce, std::size_t nonce_size, const uint8_t* digest, std::size_t digest_size )
+{
+   std::memcpy( out, nonce, nonce_size );
+   std::memcpy( out + nonce_size, digest + digest_prefix_size, digest_size - digest_prefix_size );
+}
+
+constexpr uint256_t target_for( const uint256_t& difficulty )
+{
+   return uint256_t::max() / difficulty;
+}
+
+inline bool meets_target( const uint8_t* hash, const uint8_t* target )
+{
+   return std::memcmp( hash, target, hash_size ) <= 0;
+}
+
+} // koinos::contracts::pow
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <koinos/system/system_calls.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+// string_view keyed overloads of the object, event and hash system calls.
+//
+// Keys, impacted accounts and hash inputs are passed by view so they can be
+// taken straight out of deserialized arguments or stack buffers instead of
+// being copied into a std::string first. The std::string overloads remain
+// available from the SDK.
+//
+// Events are encoded straight into the system call buffer, with the payload
+// serialized in place, so emitting one neither allocates nor stages a copy of
+// chain::event_arguments on the stack.
+
+namespace koinos::system {
+
+namespace detail {
+
+// Length delimited field tags of chain::event_arguments
+constexpr uint8_t event_name_tag     = 0x0a;
+constexpr uint8_t event_data_tag     = 0x12;
+constexpr uint8_t event_impacted_tag = 0x1a;
+
+// Tag and the longest length prefix a field within syscall_buffer can have
+constexpr std::size_t max_field_header_size = 1 + 5;
+
+// Tag and length prefix of a field holding size bytes
+constexpr std::size_t field_header_size( std::size_t size )
+{
+   std::size_t n = 2;
+   while ( size >>= 7 )
+      n++;
+   return n;
+}
+
+[[noreturn]] inline void event_overflow()
+{
+   revert( "event does not fit in the system call buffer" );
+}
+
+// Fields are only written once the room for all of their bytes is checked
+inline uint8_t* put_field_header( uint8_t* out, uint8_t* end, uint8_t tag, std::size_t size )
+{
+   if ( std::size_t( end - out ) < field_header_size( size ) )
+      event_overflow();
+
+   *out++ = tag;
+   do
+   {
+      *out++ = uint8_t( ( size & 0x7f ) | ( size > 0x7f ? 0x80 : 0 ) );
+      size >>= 7;
+   } while ( size );
+   return out;
+}
+
+inline uint8_t* put_field( uint8_t* out, uint8_t* end, uint8_t tag, std::string_view value )
+{
+   if ( std::size_t( end - out ) < field_header_size( value.size() ) + value.size() )
+      event_overflow();
+
+   out = put_field_header( out, end, tag, value.size() );
+   std::memcpy( out, value.data(), value.size() );
+   return out + value.size();
+}
+
+// Encodes the chain::event_arguments of an event into [out, end) and returns
+// the end of the encoding, reverting when it does not fit. This is the
+// encoding serializing chain::event_arguments would give, as
+// bench/event_encoding_check verifies.
+template< typename T >
+uint8_t* encode_event( uint8_t* out, uint8_t* end, std::string_view name, const T& data, std::initializer_list< std::string_view > impacted )
+{
+   out = put_field( out, end, event_name_tag, name );
+
+   // The payload is serialized past the room for its field header and moved
+   // down once its length, and so the header size, is known. An empty payload
+   // is the default value and is left out. Room for the longest header is
+   // kept even when a shorter one would do, so a payload that only fits with
+   // a short header reverts all the same.
+   auto payload_begin = out + std::min( max_field_header_size, std::size_t( end - out ) );
+   koinos::write_buffer payload( payload_begin, end - payload_begin );
+   if ( data.serialize( payload ) != ::EmbeddedProto::Error::NO_ERRORS )
+      event_overflow();
+
+   if ( payload.get_size() )
+   {
+      auto data_begin = put_field_header( out, end, event_data_tag, payload.get_size() );
+      std::memmove( data_begin, payload_begin, payload.get_size() );
+      out = data_begin + payload.get_size();
+   }
+
+   for ( auto account : impacted )
+      out = put_field( out, end, event_impacted_tag, account );
+
+   return out;
+}
+
+} // detail
+
+#ifndef BUILD_FOR_HOST
+namespace detail {
+
+using get_object_arguments = chain::get_object_arguments< max_hash_size, max_hash_size >;
+using get_object_result    = chain::get_object_result< max_argument_size, max_hash_size >;
+using put_object_arguments = chain::put_object_arguments< max_hash_size, max_hash_size, max_argument_size >;
+using remove_object_arguments = chain::remove_object_arguments< max_hash_size, max_hash_size >;
+using hash_arguments          = chain::hash_arguments< max_argument_size >;
+using hash_result             = chain::hash_result< max_hash_size >;
+
+inline void set_space( chain::object_space< max_hash_size >& dst, const object_space& src )
+{
+   dst.mutable_zone().set( src.get_zone().get_const(), src.get_zone().get_length() );
+   dst.set_id( src.get_id() );
+   dst.set_system( src.get_system() );
+}
+
+inline uint32_t invoke( chain::system_call_id id, const uint8_t* args, std::size_t size )
+{
+   uint32_t bytes_written = 0;
+
+   invoke_system_call(
+      std::underlying_type_t< chain::system_call_id >( id ),
+      reinterpret_cast< char* >( syscall_buffer.data() ),
+      std::size( syscall_buffer ),
+      reinterpret_cast< char* >( const_cast< uint8_t* >( args ) ),
+      size,
+      &bytes_written
+   );
+
+   return bytes_written;
+}
+
+inline uint32_t invoke( chain::system_call_id id, const koinos::write_buffer& args )
+{
+   return invoke( id, args.data(), args.get_size() );
+}
+
+// Serialized object bytes, or an empty string when the object does not exist
+inline std::string get_object( const object_space& space, std::string_view key )
+{
+   get_object_arguments args;
+   set_space( args.mutable_space(), space );
+   args.mutable_key().set( reinterpret_cast< const uint8_t* >( key.data() ), key.size() );
+
+   koinos::write_buffer buffer( syscall_buffer.data(), syscall_buffer.size() );
+   args.serialize( buffer );
+
+   auto bytes_written = invoke( chain::system_call_id::get_object, buffer );
+
+   get_object_result res;
+   koinos::read_buffer rdbuf( syscall_buffer.data(), bytes_written );
+   res.deserialize( rdbuf );
+
+   const auto& value = res.get_value().get_value();
+   return std::string( reinterpret_cast< const char* >( value.get_const() ), value.get_length() );
+}
+
+inline void put_object( const object_space& space, std::string_view key, std::string_view obj )
+{
+   put_object_arguments args;
+   set_space( args.mutable_space(), space );
+   args.mutable_key().set( reinterpret_cast< const uint8_t* >( key.data() ), key.size() );
+   args.mutable_obj().set( reinterpret_cast< const uint8_t* >( obj.data() ), obj.size() );
+
+   koinos::write_buffer buffer( syscall_buffer.data(), syscall_buffer.size() );
+   args.serialize( buffer );
+
+   invoke( chain::system_call_id::put_object, buffer );
+}
+
+inline void remove_object( const object_space& space, std::string_view key )
+{
+   remove_object_arguments args;
+   set_space( args.mutable_space(), space );
+   args.mutable_key().set( reinterpret_cast< const uint8_t* >( key.data() ), key.size() );
+
+   koinos::write_buffer buffer( syscall_buffer.data(), syscall_buffer.size() );
+   args.serialize( buffer );
+
+   invoke( chain::system_call_id::remove_object, buffer );
+}
+
+// Multihash of obj, moved to the front of syscall_buffer
+inline std::string_view hash( uint64_t code, std::string_view obj, uint64_t size )
+{
+   hash_arguments args;
+   args.set_code( code );
+   args.mutable_obj().set( reinterpret_cast< const uint8_t* >( obj.data() ), obj.size() );
+   args.set_size( size );
+
+   koinos::write_buffer buffer( syscall_buffer.data(), syscall_buffer.size() );
+   args.serialize( buffer );
+
+   auto bytes_written = invoke( chain::system_call_id::hash, buffer );
+
+   hash_result res;
+   koinos::read_buffer rdbuf( syscall_buffer.data(), bytes_written );
+   res.deserialize( rdbuf );
+
+   const auto& value = res.get_value();
+   std::memcpy( syscall_buffer.data(), value.get_const(), value.get_length() );
+   return std::string_view( reinterpret_cast< const char* >( syscall_buffer.data() ), value.get_length() );
+}
+
+template< typename T >
+void event( std::string_view name, const T& data, std::initializer_list< std::string_view > impacted )
+{
+   auto out = encode_event( syscall_buffer.data(), syscall_buffer.data() + syscall_buffer.size(), name, data, impacted );
+   invoke( chain::system_call_id::event, syscall_buffer.data(), out - syscall_buffer.data() );
+}
+
+} // detail
+#endif
+
+template< typename T >
+bool get_object( const object_space& space, std::string_view key, T& t )
+{
+   auto obj = detail::get_object( space, key );
+   if ( !obj.size() )
+      return false;
+
+   koinos::read_buffer rdbuf( reinterpret_cast< uint8_t* >( obj.data() ), obj.size() );
+   t.deserialize( rdbuf );
+   return true;
+}
+
+template< typename T >
+void put_object( const object_space& space, std::string_view key, const T& t )
+{
+   koinos::write_buffer buffer( detail::syscall_buffer.data(), detail::syscall_buffer.size() );
+   t.serialize( buffer );
+   detail::put_object( space, key, std::string_view( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() ) );
+}
+
+inline void remove_object( const object_space& space, std::string_view key )
+{
+   detail::remove_object( space, key );
+}
+
+// The multihash is a view of the system call buffer and only valid until the
+// next system call
+inline std::string_view hash( uint64_t code, std::string_view obj, uint64_t size = 0 )
+{
+   return detail::hash( code, obj, size );
+}
+
+// Event names are expected to be compile-time constants, e.g. a constexpr
+// std::string_view, and impacted accounts views of the event's own fields
+template< typename T >
+void event( std::string_view name, const T& data, std::initializer_list< std::string_view > impacted )
+{
+#ifdef BUILD_FOR_HOST
+   koinos::write_buffer buffer( detail::syscall_buffer.data(), detail::syscall_buffer.size() );
+   data.serialize( buffer );
+   detail::event( name, std::string_view( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() ), impacted );
+#else
+   detail::event( name, data, impacted );
+#endif
+}
+
+} // koinos::system
+
+namespace koinos::contracts {
+
+// View of a bytes field, valid for as long as the message it belongs to
+template< typename Bytes >
+std::string_view view( const Bytes& bytes )
+{
+   return std::string_view( reinterpret_cast< const char* >( bytes.get_const() ), bytes.get_length() );
+}
+
+} // koinos::contracts
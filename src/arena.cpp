@@ -0,0 +1,122 @@
+#include <koinos/contracts/arena.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#ifdef BUILD_FOR_HOST
+#include <dlfcn.h>
+#endif
+
+// Arena builds link this into every contract. See koinos/contracts/arena.hpp.
+
+namespace koinos::contracts::arena {
+
+namespace {
+
+constexpr std::size_t arena_size = 64 * 1024;
+constexpr std::size_t alignment  = alignof( std::max_align_t );
+
+// Zero initialized, so the region costs nothing at startup
+alignas( alignment ) uint8_t region[ arena_size ];
+std::size_t top;
+uint32_t depth;
+
+// Host modules bind operator new to their own, so requests the region cannot
+// hold go to the process's global operator new explicitly. Harnesses that
+// count allocations through it then see them.
+void* heap_allocate( std::size_t size )
+{
+#ifdef BUILD_FOR_HOST
+   static auto global_new = reinterpret_cast< void*(*)( std::size_t ) >( dlsym( RTLD_DEFAULT, "_Znwm" ) );
+   return global_new( size );
+#else
+   if ( void* p = std::malloc( size ? size : 1 ) )
+      return p;
+
+   std::abort();
+#endif
+}
+
+void heap_deallocate( void* p )
+{
+#ifdef BUILD_FOR_HOST
+   static auto global_delete = reinterpret_cast< void(*)( void* ) >( dlsym( RTLD_DEFAULT, "_ZdlPv" ) );
+   global_delete( p );
+#else
+   std::free( p );
+#endif
+}
+
+bool owns( const void* p )
+{
+   auto b = static_cast< const uint8_t* >( p );
+   return b >= region && b < region + arena_size;
+}
+
+void* allocate( std::size_t size )
+{
+   std::size_t begin = ( top + alignment - 1 ) & ~( alignment - 1 );
+
+   if ( begin <= arena_size && size <= arena_size - begin )
+   {
+      top = begin + size;
+      return region + begin;
+   }
+
+   return heap_allocate( size );
+}
+
+void deallocate( void* p )
+{
+   if ( p && !owns( p ) )
+      heap_deallocate( p );
+}
+
+} // anonymous
+
+void enter()
+{
+   depth++;
+}
+
+void leave()
+{
+   if ( --depth == 0 )
+      top = 0;
+}
+
+} // koinos::contracts::arena
+
+using namespace koinos::contracts;
+
+void* operator new( std::size_t size )
+{
+   return arena::allocate( size );
+}
+
+void* operator new[]( std::size_t size )
+{
+   return arena::allocate( size );
+}
+
+void operator delete( void* p ) noexcept
+{
+   arena::deallocate( p );
+}
+
+void operator delete[]( void* p ) noexcept
+{
+   arena::deallocate( p );
+}
+
+void operator delete( void* p, std::size_t ) noexcept
+{
+   arena::deallocate( p );
+}
+
+void operator delete[]( void* p, std::size_t ) noexcept
+{
+   arena::deallocate( p );
+}
@@ -0,0 +1,136 @@
+#include <koinos/system/system_calls.hpp>
+
+#include <koinos/contracts/metrics.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <tuple>
+
+// Metrics builds link every contract with --wrap=invoke_system_call, so calls
+// from the contract and from the precompiled SDK libraries alike resolve to
+// __wrap_invoke_system_call below. __real_invoke_system_call is the VM import.
+extern "C" void __real_invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written );
+
+namespace koinos::contracts::metrics {
+
+namespace {
+
+constexpr std::size_t max_system_call_ids = 32;
+constexpr std::size_t max_message_size    = 1024;
+
+struct system_call_count
+{
+   uint32_t id;
+   uint32_t count;
+};
+
+// Zero initialized, so tracking costs nothing at startup
+struct counters
+{
+   uint32_t entry_point;
+   uint64_t argument_bytes;
+   uint64_t result_bytes;
+   uint32_t objects_read;
+   uint32_t objects_written;
+   uint64_t object_bytes_read;
+   uint64_t object_bytes_written;
+   uint32_t system_calls;
+   std::array< system_call_count, max_system_call_ids > by_id;
+   std::size_t num_ids;
+} state;
+
+// emit() serializes its log into syscall_buffer, which usually holds the exit
+// arguments, so they are set aside here first
+std::array< uint8_t, std::tuple_size_v< decltype( system::detail::syscall_buffer ) > > exit_arguments;
+
+template< chain::system_call_id Id >
+constexpr bool is( uint32_t sid )
+{
+   return sid == std::underlying_type_t< chain::system_call_id >( Id );
+}
+
+void count( uint32_t sid )
+{
+   state.system_calls++;
+
+   for ( std::size_t i = 0; i < state.num_ids; i++ )
+   {
+      if ( state.by_id[i].id == sid )
+      {
+         state.by_id[i].count++;
+         return;
+      }
+   }
+
+   if ( state.num_ids < max_system_call_ids )
+      state.by_id[ state.num_ids++ ] = system_call_count{ sid, 1 };
+}
+
+void emit()
+{
+   std::array< char, max_message_size > msg;
+   std::size_t len = std::snprintf( msg.data(), msg.size(),
+      "metrics entry=0x%08x args=%llu result=%llu objects_read=%u objects_written=%u object_bytes_read=%llu object_bytes_written=%llu syscalls=%u",
+      state.entry_point,
+      (unsigned long long)state.argument_bytes,
+      (unsigned long long)state.result_bytes,
+      state.objects_read,
+      state.objects_written,
+      (unsigned long long)state.object_bytes_read,
+      (unsigned long long)state.object_bytes_written,
+      state.system_calls );
+
+   for ( std::size_t i = 0; i < state.num_ids && len < msg.size(); i++ )
+      len += std::snprintf( msg.data() + len, msg.size() - len, " %u:%u", state.by_id[i].id, state.by_id[i].count );
+
+   system::log( std::string( msg.data(), std::min( len, msg.size() - 1 ) ) );
+}
+
+} // anonymous
+
+void begin_entry( uint32_t entry_point, std::size_t argument_bytes )
+{
+   state.entry_point    = entry_point;
+   state.argument_bytes = argument_bytes;
+}
+
+void end_entry( std::size_t result_bytes )
+{
+   state.result_bytes = result_bytes;
+}
+
+} // koinos::contracts::metrics
+
+extern "C" void __wrap_invoke_system_call( uint32_t sid, char* ret_ptr, uint32_t ret_len, char* arg_ptr, uint32_t arg_len, uint32_t* bytes_written )
+{
+   using namespace koinos;
+   using namespace koinos::contracts::metrics;
+
+   count( sid );
+
+   if ( is< chain::system_call_id::put_object >( sid ) )
+   {
+      state.objects_written++;
+      state.object_bytes_written += arg_len;
+   }
+   else if ( is< chain::system_call_id::exit >( sid ) && arg_len <= exit_arguments.size() )
+   {
+      // Execution does not return from exit, so this is the last chance to report
+      std::memcpy( exit_arguments.data(), arg_ptr, arg_len );
+      emit();
+      arg_ptr = reinterpret_cast< char* >( exit_arguments.data() );
+   }
+
+   __real_invoke_system_call( sid, ret_ptr, ret_len, arg_ptr, arg_len, bytes_written );
+
+   if ( is< chain::system_call_id::get_object >( sid )
+     || is< chain::system_call_id::get_next_object >( sid )
+     || is< chain::system_call_id::get_prev_object >( sid ) )
+   {
+      state.objects_read++;
+      state.object_bytes_read += *bytes_written;
+   }
+}
@@ -0,0 +1,607 @@
+// Runs blocks of KOIN transfers and mints with optimistic parallel execution
+// on worker threads, and reports the measured speedup over serial execution
+// next to the speedup modeled from the blocks' conflicts, by core count, for
+// workloads of increasing account skew.
+//
+// Each block first runs serially, which gives the reference state, results
+// and the serial wall time. It then runs in optimistic rounds. Every pending
+// invocation executes against the state committed so far while its object
+// reads and writes are recorded. Invocations are then committed in block
+// order. An invocation aborts when it read an object written earlier in the
+// round, or when it touched an object also touched by an earlier invocation
+// that aborted. Aborted invocations are executed again in the next round.
+//
+// A round's invocations are handed out to the worker threads, which each run
+// their own system call mock with a private copy of the KOIN module and of the
+// committed state. The main thread validates and commits the round, and the
+// workers apply the committed writes before executing the next one. The
+// measured figure is the wall time of the serial run over the wall time of all
+// rounds, commits included, and is only reported for thread counts the
+// machine has hardware threads for. The modeled figure schedules the single
+// threaded execution times of each round onto N cores with a barrier between
+// rounds, ignoring contention and synchronization, so it is an upper bound.
+// Every run's final state and results are checked against serial execution.
+//
+// usage: conflict_model [<block size>]
+
+#include <koinos/contracts.hpp>
+#include <koinos/buffer.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <koinos/contracts/token/token.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace koinos;
+
+namespace constants {
+
+constexpr std::size_t address_size       = 25;
+constexpr std::size_t max_buffer_size    = 256;
+constexpr std::size_t num_accounts       = 10'000;
+constexpr std::size_t default_block_size = 2'000;
+constexpr uint64_t initial_balance       = 1'000'000'000'000;
+constexpr uint64_t block_time_ms         = 1'640'995'200'000;
+constexpr double mint_share              = 0.01;
+constexpr std::array< double, 5 > skews  = { 0.0, 0.6, 1.0, 1.4, 2.0 }; // Zipf exponents
+constexpr std::array< unsigned, 7 > cores = { 1, 2, 4, 8, 16, 32, 64 };
+
+} // constants
+
+namespace entries {
+
+constexpr uint32_t transfer = 0x27f576ca;
+constexpr uint32_t mint     = 0xdc6f17bb;
+
+} // entries
+
+using object_store = std::unordered_map< std::string, std::string >;
+
+// Value an object was left with, nullopt when it was removed
+using effect = std::pair< std::string, std::optional< std::string > >;
+
+struct invocation
+{
+   uint32_t    entry_point;
+   std::string args;
+};
+
+// Outcome of one execution of an invocation
+struct execution
+{
+   int32_t               code;
+   std::string           result;
+   uint64_t              ns;
+   mock::access_set      accesses;
+   std::vector< effect > effects;
+};
+
+template< typename T >
+std::string serialize( const T& t )
+{
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   t.serialize( buffer );
+   return std::string( reinterpret_cast< const char* >( buffer.data() ), buffer.get_size() );
+}
+
+template< typename Bytes >
+void set_bytes( Bytes& b, const std::string& s )
+{
+   b.set( reinterpret_cast< const uint8_t* >( s.data() ), s.size() );
+}
+
+std::string make_address( uint64_t i )
+{
+   std::string a( constants::address_size, '\0' );
+   for ( std::size_t b = 0; b < sizeof( i ); b++ )
+      a[ constants::address_size - 1 - b ] = char( i >> ( b * 8 ) );
+   a[1] = '\x6b';
+   return a;
+}
+
+// Draws account indices with probability proportional to 1 / rank^skew
+class zipf
+{
+public:
+   zipf( std::size_t n, double skew )
+   {
+      double sum = 0;
+      for ( std::size_t i = 1; i <= n; i++ )
+      {
+         sum += 1.0 / std::pow( double( i ), skew );
+         _cdf.push_back( sum );
+      }
+      for ( auto& c : _cdf )
+         c /= sum;
+   }
+
+   std::size_t operator()( std::mt19937_64& rng )
+   {
+      double u = std::uniform_real_distribution< double >( 0, 1 )( rng );
+      return std::min( std::size_t( std::lower_bound( _cdf.begin(), _cdf.end(), u ) - _cdf.begin() ), _cdf.size() - 1 );
+   }
+
+private:
+   std::vector< double > _cdf;
+};
+
+std::vector< invocation > make_block( const std::vector< std::string >& accounts, double skew, std::size_t size, std::mt19937_64& rng )
+{
+   zipf pick( accounts.size(), skew );
+   std::bernoulli_distribution is_mint( constants::mint_share );
+   std::vector< invocation > block;
+
+   while ( block.size() < size )
+   {
+      const auto& from = accounts[ pick( rng ) ];
+
+      if ( is_mint( rng ) )
+      {
+         contracts::token::mint_arguments< constants::address_size > args;
+         set_bytes( args.mutable_to(), from );
+         args.set_value( 1 + rng() % 100 );
+         block.push_back( { entries::mint, serialize( args ) } );
+         continue;
+      }
+
+      const auto& to = accounts[ pick( rng ) ];
+      if ( to == from )
+         continue;
+
+      contracts::token::transfer_arguments< constants::address_size, constants::address_size > args;
+      set_bytes( args.mutable_from(), from );
+      set_bytes( args.mutable_to(), to );
+      args.set_value( 1 + rng() % 100 );
+      block.push_back( { entries::transfer, serialize( args ) } );
+   }
+
+   return block;
+}
+
+// Runs one invocation against the mock's current state and records what it
+// read, and the values it left in the objects it wrote
+execution execute( const invocation& inv )
+{
+   const auto& koin_id = contracts::koin_address();
+
+   mock::clear_accesses();
+   mock::clear_events();
+
+   auto start = std::chrono::steady_clock::now();
+   auto [ code, result ] = mock::invoke( koin_id, inv.entry_point, inv.args );
+   auto elapsed = std::chrono::steady_clock::now() - start;
+
+   execution e{ code, std::move( result ), uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count() ), mock::accesses(), {} };
+
+   // A failed invocation was rolled back and leaves nothing to commit
+   if ( code == 0 )
+   {
+      const auto& objects = mock::objects();
+      for ( const auto& key : e.accesses.writes )
+      {
+         auto itr = objects.find( key );
+         e.effects.emplace_back( key, itr == objects.end() ? std::nullopt : std::optional< std::string >( itr->second ) );
+      }
+   }
+
+   return e;
+}
+
+void commit( object_store& store, const execution& e )
+{
+   for ( const auto& [ key, value ] : e.effects )
+   {
+      if ( value )
+         store[ key ] = *value;
+      else
+         store.erase( key );
+   }
+}
+
+// Brings the calling thread's mock up to date with committed writes
+void apply( const std::vector< effect >& effects )
+{
+   for ( const auto& [ key, value ] : effects )
+   {
+      if ( value )
+         mock::set_object( key, *value );
+      else
+         mock::remove_object( key );
+   }
+}
+
+// Puts the objects an execution wrote back to their committed values
+void undo( const object_store& store, const execution& e )
+{
+   for ( const auto& key : e.accesses.writes )
+   {
+      if ( auto itr = store.find( key ); itr != store.end() )
+         mock::set_object( key, itr->second );
+      else
+         mock::remove_object( key );
+   }
+}
+
+bool intersects( const std::set< std::string >& a, const std::set< std::string >& b )
+{
+   auto i = a.begin(), j = b.begin();
+   while ( i != a.end() && j != b.end() )
+   {
+      if ( *i < *j )
+         i++;
+      else if ( *j < *i )
+         j++;
+      else
+         return true;
+   }
+   return false;
+}
+
+void load_state( const object_store& store )
+{
+   mock::reset_state();
+   for ( const auto& [ key, value ] : store )
+      mock::set_object( key, value );
+}
+
+// Longest per-core busy time when the round's executions are handed, in
+// block order, to whichever core frees up first
+uint64_t makespan( const std::vector< uint64_t >& ns, unsigned cores )
+{
+   std::priority_queue< uint64_t, std::vector< uint64_t >, std::greater< uint64_t > > busy;
+   for ( unsigned c = 0; c < cores; c++ )
+      busy.push( 0 );
+
+   uint64_t span = 0;
+   for ( auto t : ns )
+   {
+      auto free_at = busy.top() + t;
+      busy.pop();
+      busy.push( free_at );
+      span = std::max( span, free_at );
+   }
+   return span;
+}
+
+// Everything but the object store that invocations expect of the calling
+// thread's mock
+void configure_mock( const std::vector< std::string >& accounts )
+{
+   mock::set_caller( "", chain::privilege::kernel_mode );
+   mock::set_head_block_time( constants::block_time_ms );
+   mock::set_head_height( 1 );
+   for ( const auto& account : accounts )
+      mock::set_authority( account, true );
+   mock::track_accesses( true );
+}
+
+// Threads that each drive their own system call mock. The mock is per thread
+// but a module's statics are per loaded file, so every worker loads a private
+// copy of the KOIN module.
+class worker_pool
+{
+public:
+   worker_pool( unsigned threads, const std::vector< std::string >& accounts )
+   {
+      for ( unsigned id = 0; id < threads; id++ )
+         _workers.emplace_back( [this, id]{ work( id ); } );
+
+      dispatch( threads, [&]( unsigned id ){ setup( id, accounts ); } );
+   }
+
+   ~worker_pool()
+   {
+      {
+         std::lock_guard< std::mutex > lock( _mutex );
+         _stop = true;
+      }
+      _wake.notify_all();
+
+      for ( auto& worker : _workers )
+         worker.join();
+   }
+
+   unsigned size() const
+   {
+      return unsigned( _workers.size() );
+   }
+
+   bool failed() const
+   {
+      return _failed;
+   }
+
+   // Runs job( id ) on workers 0 to threads - 1 and waits for all of them
+   void dispatch( unsigned threads, std::function< void( unsigned ) > job )
+   {
+      std::unique_lock< std::mutex > lock( _mutex );
+      _job      = std::move( job );
+      _active   = threads;
+      _finished = 0;
+      _generation++;
+      _wake.notify_all();
+      _idle.wait( lock, [&]{ return _finished == _active; } );
+   }
+
+private:
+   void work( unsigned id )
+   {
+      uint64_t seen = 0;
+      std::unique_lock< std::mutex > lock( _mutex );
+
+      for ( ;; )
+      {
+         _wake.wait( lock, [&]{ return _stop || ( _generation != seen && id < _active ); } );
+         if ( _stop )
+            return;
+
+         seen = _generation;
+         lock.unlock();
+         _job( id );
+         lock.lock();
+
+         if ( ++_finished == _active )
+            _idle.notify_one();
+      }
+   }
+
+   void setup( unsigned id, const std::vector< std::string >& accounts )
+   {
+      namespace fs = std::filesystem;
+
+      // dlopen returns the module already loaded from a file rather than a
+      // second instance, so each worker loads its own copy
+      auto path = fs::temp_directory_path() / ( "conflict_model." + std::to_string( ::getpid() ) + "." + std::to_string( id ) + ".so" );
+
+      try
+      {
+         fs::copy_file( KOIN_MODULE, path, fs::copy_options::overwrite_existing );
+         mock::load_contract( contracts::koin_address(), path.string(), true );
+      }
+      catch ( const std::exception& e )
+      {
+         std::fprintf( stderr, "worker %u could not load the KOIN module: %s\n", id, e.what() );
+         _failed = true;
+      }
+
+      std::error_code ec;
+      fs::remove( path, ec );
+      configure_mock( accounts );
+   }
+
+   std::vector< std::thread >           _workers;
+   std::mutex                           _mutex;
+   std::condition_variable              _wake;
+   std::condition_variable              _idle;
+   std::function< void( unsigned ) >    _job;
+   uint64_t                             _generation = 0;
+   unsigned                             _active     = 0;
+   unsigned                             _finished   = 0;
+   bool                                 _stop       = false;
+   std::atomic< bool >                  _failed { false };
+};
+
+struct serial_result
+{
+   uint64_t                 ns      = 0; // Sum of the invocations' execution times
+   uint64_t                 wall_ns = 0;
+   std::vector< execution > executions;
+   object_store             state;
+};
+
+struct optimistic_result
+{
+   uint64_t                               wall_ns    = 0;
+   std::vector< std::vector< uint64_t > > rounds;     // Execution times, in block order
+   std::size_t                            executions = 0;
+   bool                                   matches    = true;
+};
+
+// Runs a block one invocation at a time on the calling thread
+serial_result run_serial( const object_store& genesis, const std::vector< invocation >& block )
+{
+   serial_result r;
+   load_state( genesis );
+
+   auto start = std::chrono::steady_clock::now();
+   for ( const auto& inv : block )
+      r.executions.push_back( execute( inv ) );
+   r.wall_ns = uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count() );
+
+   for ( const auto& e : r.executions )
+      r.ns += e.ns;
+   r.state = mock::objects();
+   return r;
+}
+
+// Runs a block in optimistic rounds on the first `threads` workers of the pool
+optimistic_result run_optimistic( worker_pool& pool, unsigned threads, const object_store& genesis, const std::vector< invocation >& block, const serial_result& serial )
+{
+   optimistic_result r;
+   pool.dispatch( threads, [&]( unsigned ){ load_state( genesis ); } );
+
+   object_store committed = genesis;
+   std::vector< effect > unapplied; // Committed since the workers last executed
+   std::vector< std::size_t > pending( block.size() );
+   for ( std::size_t i = 0; i < pending.size(); i++ )
+      pending[i] = i;
+
+   auto start = std::chrono::steady_clock::now();
+
+   while ( !pending.empty() )
+   {
+      std::vector< execution > round( pending.size() );
+      std::atomic< std::size_t > claimed{ 0 };
+
+      pool.dispatch( threads, [&]( unsigned )
+      {
+         apply( unapplied );
+         for ( std::size_t j; ( j = claimed++ ) < pending.size(); )
+         {
+            round[j] = execute( block[ pending[j] ] );
+            undo( committed, round[j] );
+         }
+      } );
+
+      unapplied.clear();
+
+      std::vector< uint64_t > ns;
+      for ( const auto& e : round )
+         ns.push_back( e.ns );
+
+      r.executions += round.size();
+      r.rounds.push_back( std::move( ns ) );
+
+      std::set< std::string > written, aborted_reads, aborted_writes;
+      std::vector< std::size_t > next;
+
+      for ( std::size_t j = 0; j < pending.size(); j++ )
+      {
+         auto& e = round[j];
+
+         bool conflict = intersects( e.accesses.reads, written )
+            || intersects( e.accesses.reads, aborted_writes )
+            || intersects( e.accesses.writes, aborted_reads )
+            || intersects( e.accesses.writes, aborted_writes );
+
+         if ( conflict )
+         {
+            aborted_reads.insert( e.accesses.reads.begin(), e.accesses.reads.end() );
+            aborted_writes.insert( e.accesses.writes.begin(), e.accesses.writes.end() );
+            next.push_back( pending[j] );
+            continue;
+         }
+
+         commit( committed, e );
+         for ( const auto& [ key, value ] : e.effects )
+            written.insert( key );
+         unapplied.insert( unapplied.end(), e.effects.begin(), e.effects.end() );
+
+         const auto& s = serial.executions[ pending[j] ];
+         r.matches &= e.code == s.code && e.result == s.result;
+      }
+
+      pending = std::move( next );
+   }
+
+   r.wall_ns = uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - start ).count() );
+   r.matches &= committed == serial.state;
+   return r;
+}
+
+int main( int argc, char** argv )
+{
+   std::size_t block_size = argc > 1 ? std::strtoull( argv[1], nullptr, 10 ) : constants::default_block_size;
+   if ( block_size == 0 )
+   {
+      std::fprintf( stderr, "usage: %s [<block size>]\n", argv[0] );
+      return 2;
+   }
+
+   std::vector< std::string > accounts;
+   for ( std::size_t i = 0; i < constants::num_accounts; i++ )
+      accounts.push_back( make_address( i ) );
+
+   const auto& koin_id = contracts::koin_address();
+   mock::load_contract( koin_id, KOIN_MODULE, true );
+   configure_mock( accounts );
+   mock::track_accesses( false );
+
+   for ( const auto& account : accounts )
+   {
+      contracts::token::mint_arguments< constants::address_size > args;
+      set_bytes( args.mutable_to(), account );
+      args.set_value( constants::initial_balance );
+      if ( mock::invoke( koin_id, entries::mint, serialize( args ) ).first != 0 )
+      {
+         std::fprintf( stderr, "could not seed account balances\n" );
+         return 1;
+      }
+   }
+
+   object_store genesis = mock::objects();
+   mock::track_accesses( true );
+
+   // Measure only on thread counts with a hardware thread each
+   unsigned hardware = std::max( std::thread::hardware_concurrency(), 1u );
+   unsigned threads  = 1;
+   for ( auto c : constants::cores )
+      if ( c <= hardware )
+         threads = c;
+
+   worker_pool pool( threads, accounts );
+   if ( pool.failed() )
+      return 1;
+
+   std::printf( "%zu invocations per block, %zu accounts, %.0f%% mints, %u worker threads\n", block_size, accounts.size(), constants::mint_share * 100, pool.size() );
+   std::printf( "speedup over serial execution by core count, modeled from single threaded execution times and measured in wall time\n\n" );
+   std::printf( "%-6s %7s %11s %8s %-9s", "skew", "rounds", "executions", "results", "speedup" );
+   for ( auto c : constants::cores )
+      std::printf( " %7u", c );
+   std::printf( "\n" );
+
+   std::mt19937_64 rng( 0x6b6f696e );
+   bool ok = true;
+
+   for ( auto skew : constants::skews )
+   {
+      auto block = make_block( accounts, skew, block_size, rng );
+      auto serial = run_serial( genesis, block );
+
+      std::vector< optimistic_result > runs;
+      bool matches = true;
+      for ( auto c : constants::cores )
+      {
+         if ( c > pool.size() )
+            break;
+         runs.push_back( run_optimistic( pool, c, genesis, block, serial ) );
+         matches &= runs.back().matches;
+      }
+      ok &= matches;
+
+      // Rounds and executions only depend on the conflicts, so every run has
+      // the same; the single threaded run's times feed the model
+      const auto& single = runs.front();
+      std::printf( "%-6.1f %7zu %10.2fx %8s %-9s", skew, single.rounds.size(), double( single.executions ) / block.size(), matches ? "match" : "MISMATCH", "modeled" );
+      for ( auto c : constants::cores )
+      {
+         uint64_t parallel_ns = 0;
+         for ( const auto& round : single.rounds )
+            parallel_ns += makespan( round, c );
+         std::printf( " %6.2fx", double( serial.ns ) / parallel_ns );
+      }
+
+      std::printf( "\n%-6s %7s %11s %8s %-9s", "", "", "", "", "measured" );
+      for ( std::size_t i = 0; i < constants::cores.size(); i++ )
+      {
+         if ( i < runs.size() )
+            std::printf( " %6.2fx", double( serial.wall_ns ) / runs[i].wall_ns );
+         else
+            std::printf( " %7s", "-" );
+      }
+      std::printf( "\n" );
+   }
+
+   return ok ? 0 : 1;
+}
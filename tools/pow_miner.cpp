@@ -0,0 +1,396 @@
+// Mines a nonce for the PoW contract and prints ready to submit
+// pow_signature_data.
+//
+// The block digest is the multihash the chain passes to the contract as
+// process_block_signature_arguments::digest. The proof must meet either the
+// given 32 byte target or the target of the given difficulty, as the contract
+// derives it. The recoverable signature covers the digest, not the nonce, so it
+// may be produced separately and passed in to be included in the output.
+//
+// Nonces are 32 bytes, a random 24 byte prefix followed by a big-endian 64-bit
+// counter. Worker threads claim counter ranges from a shared cursor and hash
+// several nonces per pass with a multi-buffer SHA-256 kernel.
+//
+// usage: pow_miner [-t <threads>] <digest> <difficulty | target> [<recoverable signature>]
+
+#include <koinos/buffer.hpp>
+#include <koinos/mock/crypto.hpp>
+
+#include <koinos/contracts/integer.hpp>
+#include <koinos/contracts/pow_target.hpp>
+
+#include <koinos/contracts/pow/pow.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace koinos;
+using namespace koinos::contracts;
+
+namespace constants {
+
+constexpr std::size_t nonce_size            = 32;
+constexpr std::size_t nonce_prefix_size     = 24;
+constexpr std::size_t digest_size           = 34;
+constexpr std::size_t max_signature_size    = 65;
+constexpr std::size_t max_buffer_size       = 256;
+constexpr uint64_t chunk_size               = 1 << 16;
+
+} // constants
+
+using pow_signature_data = koinos::contracts::pow::pow_signature_data< constants::nonce_size, constants::max_signature_size >;
+
+namespace sha256 {
+
+// Nonces hashed together, one per vector lane
+constexpr std::size_t lanes = 8;
+
+typedef uint32_t lane_t __attribute__(( vector_size( lanes * sizeof( uint32_t ) ) ));
+
+constexpr uint32_t k[64] = {
+   0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+   0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+   0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+   0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+   0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+   0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+   0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+   0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+constexpr uint32_t initial_state[8] = {
+   0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+template< typename T >
+inline T rotr( T x, uint32_t n ) { return ( x >> n ) | ( x << ( 32 - n ) ); }
+
+template< typename T >
+inline T sigma0( T x ) { return rotr( x, 7 ) ^ rotr( x, 18 ) ^ ( x >> 3 ); }
+
+template< typename T >
+inline T sigma1( T x ) { return rotr( x, 17 ) ^ rotr( x, 19 ) ^ ( x >> 10 ); }
+
+// One compression round over the working variables s[0..7]
+template< typename T, typename W >
+inline void compress_round( T* s, W kw )
+{
+   T t1 = s[7] + ( rotr( s[4], 6 ) ^ rotr( s[4], 11 ) ^ rotr( s[4], 25 ) ) + ( ( s[4] & s[5] ) ^ ( ~s[4] & s[6] ) ) + kw;
+   T t2 = ( rotr( s[0], 2 ) ^ rotr( s[0], 13 ) ^ rotr( s[0], 22 ) ) + ( ( s[0] & s[1] ) ^ ( s[0] & s[2] ) ^ ( s[1] & s[2] ) );
+   s[7] = s[6]; s[6] = s[5]; s[5] = s[4]; s[4] = s[3] + t1;
+   s[3] = s[2]; s[2] = s[1]; s[1] = s[0]; s[0] = t1 + t2;
+}
+
+inline uint32_t load_be( const uint8_t* p )
+{
+   return ( uint32_t( p[0] ) << 24 ) | ( uint32_t( p[1] ) << 16 ) | ( uint32_t( p[2] ) << 8 ) | uint32_t( p[3] );
+}
+
+inline void store_be( uint8_t* p, uint32_t v )
+{
+   p[0] = uint8_t( v >> 24 );
+   p[1] = uint8_t( v >> 16 );
+   p[2] = uint8_t( v >> 8 );
+   p[3] = uint8_t( v );
+}
+
+// Hashes the 64 byte input nonce || digest for lanes consecutive counters.
+// Only message words 6 and 7, the counter, differ between nonces, so the first
+// six rounds are computed once per job and the padding block's message
+// schedule is constant.
+class kernel
+{
+public:
+   explicit kernel( const uint8_t* input )
+   {
+      for ( int i = 0; i < 16; i++ )
+         _w[i] = load_be( input + i * 4 );
+
+      std::copy( initial_state, initial_state + 8, _midstate );
+      for ( int i = 0; i < 6; i++ )
+         compress_round( _midstate, k[i] + _w[i] );
+
+      uint32_t pad[64] = { 0x80000000 };
+      pad[15] = 512;
+      for ( int i = 16; i < 64; i++ )
+         pad[i] = sigma1( pad[i - 2] ) + pad[i - 7] + sigma0( pad[i - 15] ) + pad[i - 16];
+      for ( int i = 0; i < 64; i++ )
+         _pad_kw[i] = k[i] + pad[i];
+   }
+
+   // Writes the hash of the nonce with counter + l as word i of h[i][l]
+   void hash( uint64_t counter, lane_t* h ) const
+   {
+      lane_t w[64];
+      for ( int i = 0; i < 16; i++ )
+         w[i] = lane_t{} + _w[i];
+
+      for ( std::size_t l = 0; l < lanes; l++ )
+      {
+         w[6][l] = uint32_t( ( counter + l ) >> 32 );
+         w[7][l] = uint32_t( counter + l );
+      }
+
+      for ( int i = 16; i < 64; i++ )
+         w[i] = sigma1( w[i - 2] ) + w[i - 7] + sigma0( w[i - 15] ) + w[i - 16];
+
+      lane_t s[8];
+      for ( int i = 0; i < 8; i++ )
+         s[i] = lane_t{} + _midstate[i];
+
+      for ( int i = 6; i < 64; i++ )
+         compress_round( s, w[i] + k[i] );
+
+      lane_t block1[8];
+      for ( int i = 0; i < 8; i++ )
+      {
+         block1[i] = s[i] + initial_state[i];
+         s[i] = block1[i];
+      }
+
+      for ( int i = 0; i < 64; i++ )
+         compress_round( s, _pad_kw[i] );
+
+      for ( int i = 0; i < 8; i++ )
+         h[i] = s[i] + block1[i];
+   }
+
+private:
+   uint32_t _w[16];
+   uint32_t _midstate[8];
+   uint32_t _pad_kw[64];
+};
+
+} // sha256
+
+struct job
+{
+   std::array< uint8_t, 64 > input;   // Hash input with a zero counter
+   std::array< uint8_t, 32 > target;
+};
+
+struct solution
+{
+   std::array< uint8_t, constants::nonce_size > nonce;
+   std::array< uint8_t, pow::hash_size > hash;
+};
+
+class miner
+{
+public:
+   explicit miner( const job& j ) : _job( j ), _kernel( j.input.data() ) {}
+
+   void work()
+   {
+      uint32_t target_word = sha256::load_be( _job.target.data() );
+      uint64_t hashes = 0;
+      sha256::lane_t h[8];
+
+      while ( !_found.load( std::memory_order_relaxed ) )
+      {
+         uint64_t begin = _cursor.fetch_add( constants::chunk_size, std::memory_order_relaxed );
+
+         for ( uint64_t counter = begin; counter < begin + constants::chunk_size; counter += sha256::lanes )
+         {
+            _kernel.hash( counter, h );
+            hashes += sha256::lanes;
+
+            for ( std::size_t l = 0; l < sha256::lanes; l++ )
+            {
+               // The first word rules out almost every candidate, the rest is
+               // compared as the contract does
+               if ( h[0][l] > target_word )
+                  continue;
+
+               solution s;
+               for ( int i = 0; i < 8; i++ )
+                  sha256::store_be( s.hash.data() + i * 4, h[i][l] );
+
+               if ( pow::meets_target( s.hash.data(), _job.target.data() ) )
+               {
+                  std::copy( _job.input.begin(), _job.input.begin() + constants::nonce_size, s.nonce.begin() );
+                  for ( int b = 0; b < 8; b++ )
+                     s.nonce[constants::nonce_size - 1 - b] = uint8_t( ( counter + l ) >> ( b * 8 ) );
+
+                  std::lock_guard< std::mutex > lock( _mutex );
+                  if ( !_solution )
+                     _solution = s;
+                  _found = true;
+               }
+            }
+
+            if ( _found.load( std::memory_order_relaxed ) )
+               break;
+         }
+      }
+
+      _hashes += hashes;
+   }
+
+   const std::optional< solution >& result() const { return _solution; }
+   uint64_t hashes() const { return _hashes; }
+
+private:
+   const job& _job;
+   sha256::kernel _kernel;
+   std::atomic< uint64_t > _cursor{ 0 };
+   std::atomic< uint64_t > _hashes{ 0 };
+   std::atomic< bool > _found{ false };
+   std::mutex _mutex;
+   std::optional< solution > _solution;
+};
+
+std::optional< std::vector< uint8_t > > from_hex( std::string s )
+{
+   if ( s.rfind( "0x", 0 ) == 0 )
+      s = s.substr( 2 );
+
+   if ( s.size() % 2 )
+      return {};
+
+   std::vector< uint8_t > out;
+   for ( std::size_t i = 0; i < s.size(); i += 2 )
+   {
+      char* end;
+      auto byte = s.substr( i, 2 );
+      auto v = std::strtoul( byte.c_str(), &end, 16 );
+      if ( *end )
+         return {};
+      out.push_back( uint8_t( v ) );
+   }
+
+   return out;
+}
+
+std::string to_hex( const uint8_t* data, std::size_t size )
+{
+   static const char digits[] = "0123456789abcdef";
+   std::string s;
+   for ( std::size_t i = 0; i < size; i++ )
+   {
+      s += digits[data[i] >> 4];
+      s += digits[data[i] & 0xf];
+   }
+   return s;
+}
+
+int usage( const char* argv0 )
+{
+   std::fprintf( stderr, "usage: %s [-t <threads>] <digest> <difficulty | target> [<recoverable signature>]\n", argv0 );
+   return 2;
+}
+
+int main( int argc, char** argv )
+{
+   unsigned threads = std::max( std::thread::hardware_concurrency(), 1u );
+   std::vector< std::string > args;
+
+   for ( int i = 1; i < argc; i++ )
+   {
+      if ( std::strcmp( argv[i], "-t" ) == 0 && i + 1 < argc )
+         threads = std::max( std::atoi( argv[++i] ), 1 );
+      else
+         args.emplace_back( argv[i] );
+   }
+
+   if ( args.size() < 2 || args.size() > 3 )
+      return usage( argv[0] );
+
+   auto digest = from_hex( args[0] );
+   if ( !digest || digest->size() != constants::digest_size )
+   {
+      std::fprintf( stderr, "digest must be a %zu byte sha256 multihash\n", constants::digest_size );
+      return 2;
+   }
+
+   job j;
+
+   // A 32 byte target is used as is, anything else is a difficulty
+   auto target = from_hex( args[1] );
+   if ( target && target->size() == pow::hash_size )
+   {
+      std::copy( target->begin(), target->end(), j.target.begin() );
+   }
+   else
+   {
+      char* end;
+      auto difficulty = std::strtoull( args[1].c_str(), &end, 10 );
+      if ( *end || difficulty == 0 )
+         return usage( argv[0] );
+      pow::target_for( uint256_t( uint64_t( difficulty ) ) ).to_big_endian( j.target.data() );
+   }
+
+   std::optional< std::vector< uint8_t > > signature = std::vector< uint8_t >();
+   if ( args.size() == 3 )
+   {
+      signature = from_hex( args[2] );
+      if ( !signature || signature->size() > constants::max_signature_size )
+      {
+         std::fprintf( stderr, "signature must be at most %zu bytes\n", constants::max_signature_size );
+         return 2;
+      }
+   }
+
+   // Random prefix, so miners working on the same digest do not repeat each other
+   std::array< uint8_t, constants::nonce_size > nonce = {};
+   std::random_device rd;
+   for ( std::size_t i = 0; i < constants::nonce_prefix_size; i++ )
+      nonce[i] = uint8_t( rd() );
+
+   pow::hash_input( j.input.data(), nonce.data(), nonce.size(), digest->data(), digest->size() );
+
+   miner m( j );
+   auto start = std::chrono::steady_clock::now();
+
+   std::vector< std::thread > workers;
+   for ( unsigned t = 0; t < threads; t++ )
+      workers.emplace_back( [&m]{ m.work(); } );
+   for ( auto& w : workers )
+      w.join();
+
+   double elapsed = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+   const auto& s = *m.result();
+
+   // Check the solution against the reference hash over the contract's input layout
+   std::array< uint8_t, pow::hash_input_size( constants::nonce_size, constants::digest_size ) > input;
+   pow::hash_input( input.data(), s.nonce.data(), s.nonce.size(), digest->data(), digest->size() );
+   auto hash = mock::crypto::sha256( input.data(), input.size() );
+
+   if ( hash != s.hash || !pow::meets_target( hash.data(), j.target.data() ) )
+   {
+      std::fprintf( stderr, "solution %s failed verification\n", to_hex( s.nonce.data(), s.nonce.size() ).c_str() );
+      return 1;
+   }
+
+   pow_signature_data sig_data;
+   sig_data.mutable_nonce().set( s.nonce.data(), s.nonce.size() );
+   sig_data.mutable_recoverable_signature().set( signature->data(), signature->size() );
+
+   std::array< uint8_t, constants::max_buffer_size > buf;
+   koinos::write_buffer buffer( buf.data(), buf.size() );
+   sig_data.serialize( buffer );
+
+   std::fprintf( stderr, "%llu hashes in %.2fs on %u threads, %.2f MH/s\n",
+      (unsigned long long)m.hashes(),
+      elapsed,
+      threads,
+      m.hashes() / elapsed / 1e6 );
+   std::fprintf( stderr, "nonce  %s\n", to_hex( s.nonce.data(), s.nonce.size() ).c_str() );
+   std::fprintf( stderr, "proof  %s\n", to_hex( hash.data(), hash.size() ).c_str() );
+   if ( signature->empty() )
+      std::fprintf( stderr, "no recoverable signature given, sign the digest and set it before submitting\n" );
+
+   std::printf( "%s\n", to_hex( buffer.data(), buffer.get_size() ).c_str() );
+   return 0;
+}
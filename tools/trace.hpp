@@ -0,0 +1,235 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Binary trace of contract executions, as replayed by trace_replay.
+//
+// A trace is the 8 byte magic followed by records. Integers are little-endian
+// and strings are length prefixed, with the length sized for what they hold.
+//
+//    contract  u8 kind = 0, u8 id length, id
+//    object    u8 kind = 1, u8 zone length, zone, u32 space id, u8 system,
+//              u16 key length, key, u32 value length, value
+//    invoke    u8 kind = 2, u16 contract, u32 entry point, u64 head block time,
+//              u8 privilege, u8 caller length, caller,
+//              u8 authorized account count, { u8 length, account }...,
+//              u32 arguments length, arguments
+//
+// Contract records number the contracts invoke records refer to, in the order
+// they appear. Object records seed state, so a trace can start from a snapshot
+// rather than genesis. Accounts listed in an invoke record pass check_authority
+// for that invocation, as they did when it was recorded.
+
+namespace koinos::trace {
+
+constexpr char magic[8] = { 'K', 'T', 'R', 'A', 'C', 'E', '0', '1' };
+
+enum class record_kind : uint8_t
+{
+   contract = 0,
+   object   = 1,
+   invoke   = 2,
+};
+
+struct object_record
+{
+   std::string_view zone;
+   uint32_t         space_id;
+   bool             system;
+   std::string_view key;
+   std::string_view value;
+};
+
+struct invoke_record
+{
+   uint16_t                        contract;
+   uint32_t                        entry_point;
+   uint64_t                        head_block_time;
+   uint8_t                         privilege;
+   std::string_view                caller;
+   std::vector< std::string_view > authorized;
+   std::string_view                arguments;
+};
+
+// Reads a trace in place from a read-only memory mapping
+class reader
+{
+public:
+   explicit reader( const std::string& path )
+   {
+      int fd = ::open( path.c_str(), O_RDONLY );
+      if ( fd < 0 )
+         throw std::runtime_error( "could not open trace: " + path );
+
+      struct stat st;
+      if ( ::fstat( fd, &st ) == 0 && st.st_size > 0 )
+      {
+         _size = std::size_t( st.st_size );
+         void* p = ::mmap( nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0 );
+         if ( p != MAP_FAILED )
+            _data = static_cast< const uint8_t* >( p );
+      }
+      ::close( fd );
+
+      if ( !_data || _size < sizeof( magic ) || std::memcmp( _data, magic, sizeof( magic ) ) != 0 )
+         throw std::runtime_error( "not a trace: " + path );
+
+      _pos = sizeof( magic );
+   }
+
+   ~reader()
+   {
+      if ( _data )
+         ::munmap( const_cast< uint8_t* >( _data ), _size );
+   }
+
+   reader( const reader& ) = delete;
+   reader& operator=( const reader& ) = delete;
+
+   bool done() const { return _pos >= _size; }
+
+   record_kind next_kind() { return record_kind( read< uint8_t >() ); }
+
+   std::string_view read_contract() { return bytes( read< uint8_t >() ); }
+
+   object_record read_object()
+   {
+      object_record r;
+      r.zone     = bytes( read< uint8_t >() );
+      r.space_id = read< uint32_t >();
+      r.system   = read< uint8_t >() != 0;
+      r.key      = bytes( read< uint16_t >() );
+      r.value    = bytes( read< uint32_t >() );
+      return r;
+   }
+
+   // Reuses the record's authorized list between calls
+   void read_invoke( invoke_record& r )
+   {
+      r.contract        = read< uint16_t >();
+      r.entry_point     = read< uint32_t >();
+      r.head_block_time = read< uint64_t >();
+      r.privilege       = read< uint8_t >();
+      r.caller          = bytes( read< uint8_t >() );
+
+      r.authorized.clear();
+      for ( uint8_t n = read< uint8_t >(); n > 0; n-- )
+         r.authorized.push_back( bytes( read< uint8_t >() ) );
+
+      r.arguments = bytes( read< uint32_t >() );
+   }
+
+private:
+   template< typename T >
+   T read()
+   {
+      auto b = bytes( sizeof( T ) );
+      T v = 0;
+      for ( std::size_t i = 0; i < sizeof( T ); i++ )
+         v |= T( uint8_t( b[i] ) ) << ( i * 8 );
+      return v;
+   }
+
+   std::string_view bytes( std::size_t n )
+   {
+      if ( n > _size - _pos )
+         throw std::runtime_error( "truncated trace" );
+
+      std::string_view v( reinterpret_cast< const char* >( _data + _pos ), n );
+      _pos += n;
+      return v;
+   }
+
+   const uint8_t* _data = nullptr;
+   std::size_t    _size = 0;
+   std::size_t    _pos  = 0;
+};
+
+// Appends records to a trace, for recorders and workload generators
+class writer
+{
+public:
+   explicit writer( const std::string& path ) : _file( std::fopen( path.c_str(), "wb" ) )
+   {
+      if ( !_file )
+         throw std::runtime_error( "could not create trace: " + path );
+      std::fwrite( magic, 1, sizeof( magic ), _file );
+   }
+
+   ~writer()
+   {
+      std::fclose( _file );
+   }
+
+   writer( const writer& ) = delete;
+   writer& operator=( const writer& ) = delete;
+
+   // Returns the index invoke records refer to the contract by
+   uint16_t contract( std::string_view id )
+   {
+      write< uint8_t >( uint8_t( record_kind::contract ) );
+      write_bytes< uint8_t >( id );
+      return _contracts++;
+   }
+
+   void object( const object_record& r )
+   {
+      write< uint8_t >( uint8_t( record_kind::object ) );
+      write_bytes< uint8_t >( r.zone );
+      write< uint32_t >( r.space_id );
+      write< uint8_t >( r.system ? 1 : 0 );
+      write_bytes< uint16_t >( r.key );
+      write_bytes< uint32_t >( r.value );
+   }
+
+   void invoke( const invoke_record& r )
+   {
+      write< uint8_t >( uint8_t( record_kind::invoke ) );
+      write< uint16_t >( r.contract );
+      write< uint32_t >( r.entry_point );
+      write< uint64_t >( r.head_block_time );
+      write< uint8_t >( r.privilege );
+      write_bytes< uint8_t >( r.caller );
+      write< uint8_t >( uint8_t( r.authorized.size() ) );
+      for ( auto account : r.authorized )
+         write_bytes< uint8_t >( account );
+      write_bytes< uint32_t >( r.arguments );
+   }
+
+private:
+   template< typename T >
+   void write( T v )
+   {
+      uint8_t b[ sizeof( T ) ];
+      for ( std::size_t i = 0; i < sizeof( T ); i++ )
+         b[i] = uint8_t( v >> ( i * 8 ) );
+      std::fwrite( b, 1, sizeof( b ), _file );
+   }
+
+   template< typename Length >
+   void write_bytes( std::string_view s )
+   {
+      if ( s.size() > std::numeric_limits< Length >::max() )
+         throw std::length_error( "trace field too long" );
+      write< Length >( Length( s.size() ) );
+      std::fwrite( s.data(), 1, s.size(), _file );
+   }
+
+   std::FILE* _file;
+   uint16_t   _contracts = 0;
+};
+
+} // koinos::trace
@@ -0,0 +1,254 @@
+// Replays a binary trace of contract executions (see trace.hpp) against the
+// host system call mock and reports, for every contract entry point, calls,
+// failed calls, throughput, system calls per call and latency percentiles.
+//
+// Afterwards it prints a hash over every result code, result value and event,
+// and one hash over the final objects of each state zone. Replaying the same
+// trace against a baseline and a candidate build of a contract must give the
+// same results hash. A zone hash only has to match when the candidate stores
+// that zone's objects in the same layout: the resources zone differs from
+// builds that keep separate parameters and markets records rather than one
+// resources_state record and the cached limits, and the KOIN zone
+// differs between builds with and without BUILD_WITH_BALANCE_RECORDS, and
+// between builds that keep supply as one object and builds that shard it.
+//
+// usage: trace_replay <trace> <contract id>=<module> [<contract id>=<module> ...]
+
+#include "trace.hpp"
+
+#include <koinos/mock/crypto.hpp>
+#include <koinos/mock/syscall_mock.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace koinos;
+
+struct entry_stats
+{
+   uint64_t                failed       = 0;
+   uint64_t                system_calls = 0;
+   std::vector< uint64_t > latency_ns;
+};
+
+std::string to_hex( std::string_view data )
+{
+   static const char digits[] = "0123456789abcdef";
+   std::string s;
+   for ( unsigned char c : data )
+   {
+      s += digits[c >> 4];
+      s += digits[c & 0xf];
+   }
+   return s;
+}
+
+std::string to_hex( const std::array< uint8_t, 32 >& h )
+{
+   return to_hex( std::string_view( reinterpret_cast< const char* >( h.data() ), h.size() ) );
+}
+
+// Ids are usually addresses, shown and given on the command line as hex
+// unless they are readable
+std::string display( std::string_view id )
+{
+   if ( std::all_of( id.begin(), id.end(), []( char c ) { return c >= 0x20 && c < 0x7f; } ) )
+      return std::string( id );
+   return to_hex( id );
+}
+
+void append_sized( std::string& s, std::string_view v )
+{
+   uint32_t n = uint32_t( v.size() );
+   s.append( reinterpret_cast< const char* >( &n ), sizeof( n ) );
+   s.append( v );
+}
+
+uint64_t percentile( const std::vector< uint64_t >& sorted, double p )
+{
+   return sorted[ std::min( sorted.size() - 1, std::size_t( p * sorted.size() ) ) ];
+}
+
+int main( int argc, char** argv )
+{
+   if ( argc < 3 )
+   {
+      std::fprintf( stderr, "usage: %s <trace> <contract id>=<module> [<contract id>=<module> ...]\n", argv[0] );
+      return 2;
+   }
+
+   std::unordered_map< std::string, std::string > modules;
+   for ( int i = 2; i < argc; i++ )
+   {
+      std::string arg( argv[i] );
+      auto eq = arg.find( '=' );
+      if ( eq == std::string::npos )
+      {
+         std::fprintf( stderr, "expected <contract id>=<module>, got %s\n", argv[i] );
+         return 2;
+      }
+      modules[ arg.substr( 0, eq ) ] = arg.substr( eq + 1 );
+   }
+
+   trace::reader reader( argv[1] );
+
+   std::vector< std::string > contracts;
+   std::map< std::pair< uint16_t, uint32_t >, entry_stats > stats;
+   trace::invoke_record rec;
+   std::string args;
+
+   // Chained hash of every result and event, in trace order
+   std::array< uint8_t, 32 > results_hash = {};
+   std::string results;
+
+   mock::reset_counters();
+   auto start = std::chrono::steady_clock::now();
+
+   while ( !reader.done() )
+   {
+      switch ( reader.next_kind() )
+      {
+         case trace::record_kind::contract:
+         {
+            std::string id( reader.read_contract() );
+            auto itr = modules.find( display( id ) );
+            if ( itr == modules.end() )
+            {
+               std::fprintf( stderr, "no module given for contract %s\n", display( id ).c_str() );
+               return 2;
+            }
+
+            mock::load_contract( id, itr->second, true );
+            contracts.push_back( std::move( id ) );
+            break;
+         }
+         case trace::record_kind::object:
+         {
+            auto obj = reader.read_object();
+
+            system::object_space space;
+            space.mutable_zone().set( reinterpret_cast< const uint8_t* >( obj.zone.data() ), obj.zone.size() );
+            space.set_id( obj.space_id );
+            space.set_system( obj.system );
+
+            mock::set_object( space, std::string( obj.key ), std::string( obj.value ) );
+            break;
+         }
+         case trace::record_kind::invoke:
+         {
+            reader.read_invoke( rec );
+            if ( rec.contract >= contracts.size() )
+            {
+               std::fprintf( stderr, "invoke of undeclared contract %u\n", unsigned( rec.contract ) );
+               return 1;
+            }
+
+            const auto& contract = contracts[ rec.contract ];
+            mock::set_head_block_time( rec.head_block_time );
+            mock::set_caller( std::string( rec.caller ), chain::privilege( rec.privilege ) );
+            for ( auto account : rec.authorized )
+               mock::set_authority( std::string( account ), true );
+            args.assign( rec.arguments );
+
+            auto system_calls = mock::get_counters().system_calls;
+            auto begin = std::chrono::steady_clock::now();
+            auto [ code, value ] = mock::invoke( contract, rec.entry_point, args );
+            auto elapsed = std::chrono::steady_clock::now() - begin;
+
+            for ( auto account : rec.authorized )
+               mock::set_authority( std::string( account ), false );
+
+            auto& s = stats[ { rec.contract, rec.entry_point } ];
+            s.latency_ns.push_back( uint64_t( std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count() ) );
+            s.system_calls += mock::get_counters().system_calls - system_calls;
+            if ( code != 0 )
+               s.failed++;
+
+            results.assign( reinterpret_cast< const char* >( results_hash.data() ), results_hash.size() );
+            results.append( reinterpret_cast< const char* >( &code ), sizeof( code ) );
+            append_sized( results, value );
+            for ( const auto& e : mock::events() )
+            {
+               append_sized( results, e.name );
+               append_sized( results, e.data );
+            }
+            results_hash = mock::crypto::sha256( results.data(), results.size() );
+            mock::clear_events();
+            break;
+         }
+         default:
+            std::fprintf( stderr, "unknown trace record\n" );
+            return 1;
+      }
+   }
+
+   double total_s = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+   std::printf( "%-20s %10s %10s %8s %12s %10s %10s %10s %10s %10s\n",
+      "contract", "entry", "calls", "failed", "calls/s", "syscalls", "p50 us", "p90 us", "p99 us", "max us" );
+
+   uint64_t total_calls = 0;
+   for ( auto& [ key, s ] : stats )
+   {
+      auto& lat = s.latency_ns;
+      std::sort( lat.begin(), lat.end() );
+
+      uint64_t busy_ns = 0;
+      for ( auto ns : lat )
+         busy_ns += ns;
+
+      double n = double( lat.size() );
+      total_calls += lat.size();
+
+      std::printf( "%-20s 0x%08x %10zu %8llu %12.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+         display( contracts[ key.first ] ).substr( 0, 20 ).c_str(),
+         key.second,
+         lat.size(),
+         (unsigned long long)s.failed,
+         busy_ns ? n * 1e9 / double( busy_ns ) : 0.0,
+         double( s.system_calls ) / n,
+         percentile( lat, 0.50 ) / 1e3,
+         percentile( lat, 0.90 ) / 1e3,
+         percentile( lat, 0.99 ) / 1e3,
+         lat.back() / 1e3 );
+   }
+
+   std::printf( "\n%llu calls in %.3fs\n", (unsigned long long)total_calls, total_s );
+   std::printf( "%-20s %s\n", "results", to_hex( results_hash ).c_str() );
+   std::printf( "\nzone hashes, comparable only between builds with the same storage layout\n" );
+
+   // Object keys start with the length of their space's zone and the zone
+   std::map< std::string, std::vector< const std::pair< const std::string, std::string >* > > zones;
+   for ( const auto& obj : mock::objects() )
+   {
+      std::size_t zone_size = uint8_t( obj.first[0] );
+      zones[ obj.first.substr( 1, zone_size ) ].push_back( &obj );
+   }
+
+   for ( auto& [ zone, objects ] : zones )
+   {
+      std::sort( objects.begin(), objects.end(), []( auto a, auto b ) { return a->first < b->first; } );
+
+      std::string state;
+      for ( auto obj : objects )
+      {
+         append_sized( state, obj->first );
+         append_sized( state, obj->second );
+      }
+
+      std::printf( "%-20s %s (%zu objects)\n",
+         display( zone ).substr( 0, 20 ).c_str(),
+         to_hex( mock::crypto::sha256( state.data(), state.size() ) ).c_str(),
+         objects.size() );
+   }
+
+   return 0;
+}